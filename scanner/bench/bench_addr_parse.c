@@ -0,0 +1,184 @@
+// Microbenchmark for the MAC and IP address parsers against the sscanf/inet_pton path they replaced.
+// Build with -DSCANNER_BUILD_BENCHMARKS=ON and run ./bench_addr_parse
+#include "../include/addr_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#define CORPUS_SIZE 4096
+#define ITERATIONS 2000
+
+typedef int (*mac_parse_fn)(const char* str, size_t len, mac_addr_t* addr);
+typedef int (*ip_parse_fn)(const char* str, size_t len, uint8_t out[16]);
+
+// parse_mac() as it was before addr_parse.c, kept as the baseline
+static int parse_mac_legacy(const char* str, size_t len, mac_addr_t* addr) {
+    (void)len;
+    unsigned int values[6] = {0};
+    int items = sscanf(str, "%x:%x:%x:%x:%x:%x",
+                       &values[0], &values[1], &values[2],
+                       &values[3], &values[4], &values[5]);
+    if (items != 6) return -1;
+    for (int i = 0; i < 6; i++) {
+        if (values[i] > 0xFF) return -1;
+    }
+    *addr = 0;
+    for (int i = 0; i < 6; i++) *addr = *addr << 8 | values[i];
+    return 0;
+}
+
+// validate_ip() as it was, returning the family like parse_ip()
+static int parse_ip_legacy(const char* str, size_t len, uint8_t out[16]) {
+    (void)len;
+    if (inet_pton(AF_INET, str, out) == 1) return 4;
+    if (inet_pton(AF_INET6, str, out) == 1) return 6;
+    return -1;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+typedef struct {
+    char text[MAC_SCANNER_IP_STRLEN];
+    size_t len;
+} sample_t;
+
+static void format_mac(sample_t* s, const uint8_t* mac, char sep) {
+    static const char* const hex[2] = { "0123456789abcdef", "0123456789ABCDEF" };
+    const char* digits = hex[rand() & 1];
+    char* p = s->text;
+    for (int i = 0; i < 6; i++) {
+        if (i && sep != '.') *p++ = sep;
+        if (sep == '.' && (i == 2 || i == 4)) *p++ = '.';
+        *p++ = digits[mac[i] >> 4];
+        *p++ = digits[mac[i] & 0x0F];
+    }
+    *p = 0;
+    s->len = (size_t)(p - s->text);
+}
+
+static void fill_macs(sample_t* corpus, char sep) {
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        uint8_t mac[6];
+        for (int b = 0; b < 6; b++) mac[b] = (uint8_t)rand();
+        format_mac(&corpus[i], mac, sep);
+    }
+}
+
+static void fill_ipv4(sample_t* corpus) {
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        unsigned a = (unsigned)rand(), b = (unsigned)rand();
+        corpus[i].len = (size_t)snprintf(corpus[i].text, sizeof(corpus[i].text), "%u.%u.%u.%u",
+                                         a & 0xFF, (a >> 8) & 0xFF, b & 0xFF, (b >> 8) & 0xFF);
+    }
+}
+
+// Text as inet_ntop writes it, so "::" compression shows up wherever runs of zero groups occur
+static void fill_ipv6(sample_t* corpus) {
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        uint8_t addr[16] = { 0x20, 0x01, 0x0d, 0xb8 };
+        for (int b = 4; b < 16; b++) addr[b] = (rand() & 3) ? (uint8_t)rand() : 0;
+        inet_ntop(AF_INET6, addr, corpus[i].text, sizeof(corpus[i].text));
+        corpus[i].len = strlen(corpus[i].text);
+    }
+}
+
+static void run_mac(const char* label, mac_parse_fn fn, const sample_t* corpus) {
+    volatile uint32_t sink = 0;
+    double start = now_ns();
+    for (int it = 0; it < ITERATIONS; it++) {
+        for (size_t i = 0; i < CORPUS_SIZE; i++) {
+            mac_addr_t addr;
+            if (fn(corpus[i].text, corpus[i].len, &addr) == 0) sink += (uint32_t)addr;
+        }
+    }
+    double elapsed = now_ns() - start;
+    (void)sink;
+    printf("  %-8s %8.2f ns/addr\n", label, elapsed / ((double)ITERATIONS * CORPUS_SIZE));
+}
+
+static void run_ip(const char* label, ip_parse_fn fn, const sample_t* corpus) {
+    volatile uint32_t sink = 0;
+    double start = now_ns();
+    for (int it = 0; it < ITERATIONS; it++) {
+        for (size_t i = 0; i < CORPUS_SIZE; i++) {
+            uint8_t addr[16];
+            if (fn(corpus[i].text, corpus[i].len, addr) > 0) sink += addr[3];
+        }
+    }
+    double elapsed = now_ns() - start;
+    (void)sink;
+    printf("  %-8s %8.2f ns/addr\n", label, elapsed / ((double)ITERATIONS * CORPUS_SIZE));
+}
+
+// Every benchmarked input must decode to the same address on both paths
+static int check_mac(const sample_t* corpus, mac_parse_fn fn) {
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        mac_addr_t want, got;
+        if (parse_mac_legacy(corpus[i].text, corpus[i].len, &want) != 0 || fn(corpus[i].text, corpus[i].len, &got) != 0 ||
+            want != got) {
+            fprintf(stderr, "mismatch on \"%s\"\n", corpus[i].text);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int check_ip(const sample_t* corpus) {
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        uint8_t want[16] = {0}, got[16] = {0};
+        int family = parse_ip_legacy(corpus[i].text, corpus[i].len, want);
+        if (family < 0 || parse_ip(corpus[i].text, corpus[i].len, got) != family || memcmp(want, got, sizeof(want)) != 0) {
+            fprintf(stderr, "mismatch on \"%s\"\n", corpus[i].text);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    static sample_t corpus[CORPUS_SIZE];
+    srand(1);
+
+    fill_macs(corpus, ':');
+    if (check_mac(corpus, parse_mac_scalar) != 0) return EXIT_FAILURE;
+    printf("MAC aa:bb:cc:dd:ee:ff\n");
+    run_mac("sscanf", parse_mac_legacy, corpus);
+    run_mac("scalar", parse_mac_scalar, corpus);
+#if defined(__SSE2__)
+    if (check_mac(corpus, parse_mac_sse2) != 0) return EXIT_FAILURE;
+    run_mac("sse2", parse_mac_sse2, corpus);
+#endif
+
+    // sscanf never accepted these layouts, so there is no baseline to compare against
+    fill_macs(corpus, '-');
+    printf("MAC aa-bb-cc-dd-ee-ff\n");
+    run_mac("parse", parse_mac_n, corpus);
+    fill_macs(corpus, '.');
+    printf("MAC aabb.ccdd.eeff\n");
+    run_mac("parse", parse_mac_n, corpus);
+
+    fill_ipv4(corpus);
+    if (check_ip(corpus) != 0) return EXIT_FAILURE;
+    printf("IPv4\n");
+    run_ip("inet_pton", parse_ip_legacy, corpus);
+    run_ip("parse_ip", parse_ip, corpus);
+
+    fill_ipv6(corpus);
+    if (check_ip(corpus) != 0) return EXIT_FAILURE;
+    printf("IPv6\n");
+    run_ip("inet_pton", parse_ip_legacy, corpus);
+    run_ip("parse_ip", parse_ip, corpus);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,47 @@
+/**
+ * @file addr_parse.h
+ * @brief Length-delimited MAC, IPv4 and IPv6 address parsers producing binary addresses.
+ * @note Inputs need not be NUL-terminated. Every parser returns 0 on success and -1 on malformed input,
+ *       leaving the output untouched on failure.
+ * @ingroup mac_scanner
+ */
+
+#ifndef ADDR_PARSE_H
+#define ADDR_PARSE_H
+
+#include "mac_scanner.h"
+
+/**
+ * @brief Parses a MAC in "aa:bb:cc:dd:ee:ff", "aa-bb-cc-dd-ee-ff", "aabb.ccdd.eeff" or "aabbccddeeff" form.
+ * @note Exactly two hex digits per octet, either case; uses SSE2 for the 17-character forms when available.
+ */
+int parse_mac_n(const char* str, size_t len, mac_addr_t* addr);
+
+/**
+ * @brief parse_mac_n() on a NUL-terminated string.
+ */
+int parse_mac(const char* mac_str, mac_addr_t* addr);
+
+/**
+ * @brief Parses dotted-quad IPv4 with inet_pton(AF_INET) rules: four decimal octets, no leading zeros.
+ */
+int parse_ipv4(const char* str, size_t len, uint8_t out[4]);
+
+/**
+ * @brief Parses IPv6 text with inet_pton(AF_INET6) rules, including "::" and a dotted IPv4 tail.
+ */
+int parse_ipv6(const char* str, size_t len, uint8_t out[16]);
+
+/**
+ * @brief Parses either family into @p out (4 or 16 bytes used).
+ * @return MAC_SCANNER_IP_V4 or MAC_SCANNER_IP_V6 for the family parsed, -1 on malformed input.
+ */
+int parse_ip(const char* str, size_t len, uint8_t out[16]);
+
+// Individual MAC kernels, exposed for the benchmark; parse_mac_n() picks between them
+int parse_mac_scalar(const char* str, size_t len, mac_addr_t* addr);
+#if defined(__SSE2__)
+int parse_mac_sse2(const char* str, size_t len, mac_addr_t* addr);
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * @file flow_table.h
+ * @brief Open-addressing table that aggregates MAC pairs into flows.
+ * @note Pairs with the same MACs and IPs update one entry; entries leave the table as mac_flow_t records
+ *       when the table is flushed or when a new flow evicts them. Single-threaded: the event loop owns it.
+ * @ingroup mac_scanner
+ */
+
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include "mac_scanner.h"
+
+#define FLOW_TABLE_MAX_PROBE 16 ///< Slots searched from a flow's home slot before one is evicted
+
+/**
+ * @brief Receives every flow leaving the table.
+ */
+typedef void (*flow_sink_fn)(const mac_flow_t* flow, void* ctx);
+
+typedef struct flow_table flow_table_t;
+
+/**
+ * @brief Creates an empty table of @p capacity entries, a power of two.
+ * @return The table, or NULL on invalid capacity or allocation failure.
+ */
+flow_table_t* flow_table_create(size_t capacity, flow_sink_fn sink, void* ctx);
+
+/**
+ * @brief Counts @p pair towards its flow, evicting the least recently updated flow in its probe window if
+ *        the window is full.
+ */
+void flow_table_add(flow_table_t* table, const mac_pair_t* pair);
+
+/**
+ * @brief Emits every flow and empties the table.
+ * @return The number of flows emitted.
+ */
+size_t flow_table_flush(flow_table_t* table);
+
+/**
+ * @brief Flows evicted since the table was created.
+ */
+uint64_t flow_table_evictions(const flow_table_t* table);
+
+/**
+ * @brief Releases the table without emitting what it holds.
+ */
+void flow_table_free(flow_table_t* table);
+
+#endif
@@ -6,7 +6,7 @@
  * @ingroup mac_scanner
  */
 
-#ifdef MAC_SCANNER_H
+#ifndef MAC_SCANNER_H
 #define MAC_SCANNER_H
 
 #include <stdint.h>
@@ -18,3 +18,162 @@
 #define EXPORT __attribute__((visibility("default")))
 #endif
 
+#define MAC_SCANNER_IP_STRLEN 46  // INET6_ADDRSTRLEN
+#define MAC_SCANNER_MAC_STRLEN 18 // "aa:bb:cc:dd:ee:ff" and the terminator
+
+/**
+ * @brief 48-bit MAC address, first octet in bits 47-40.
+ */
+typedef uint64_t mac_addr_t;
+
+/**
+ * @brief Address family of an IP in mac_pair_t.
+ */
+enum {
+    MAC_SCANNER_IP_NONE = 0, ///< The packet carried no valid address
+    MAC_SCANNER_IP_V4 = 4,
+    MAC_SCANNER_IP_V6 = 6
+};
+
+/**
+ * @brief One observed source/destination pair as reported by an API endpoint.
+ * @note 56 bytes of binary fields, so a ring slot together with its sequence number is one cache line.
+ *       The MAC and family members are bit-fields and cannot have their address taken; read them by value.
+ *       Use mac_scanner_format_mac() and mac_scanner_format_ip() for text.
+ */
+typedef struct {
+    mac_addr_t src_mac : 48;
+    mac_addr_t src_family : 8; ///< MAC_SCANNER_IP_NONE, _V4 or _V6 for src_ip
+    mac_addr_t dst_mac : 48;
+    mac_addr_t dst_family : 8; ///< MAC_SCANNER_IP_NONE, _V4 or _V6 for dst_ip
+    uint64_t timestamp_ns;
+    uint8_t src_ip[16];        ///< Network byte order; IPv4 uses the first four bytes
+    uint8_t dst_ip[16];
+} mac_pair_t;
+
+/**
+ * @brief Packets of one (src MAC, dst MAC, src IP, dst IP) flow since the flow was last emitted.
+ * @note Emitted by the aggregation table when its flush interval passes or when it is evicted to make room.
+ *       As in mac_pair_t, the MAC and family members are bit-fields.
+ */
+typedef struct {
+    mac_addr_t src_mac : 48;
+    mac_addr_t src_family : 8;
+    mac_addr_t dst_mac : 48;
+    mac_addr_t dst_family : 8;
+    uint8_t src_ip[16];
+    uint8_t dst_ip[16];
+    uint64_t first_seen_ns;    ///< Earliest packet timestamp in the flow
+    uint64_t last_seen_ns;     ///< Latest packet timestamp in the flow
+    uint64_t packet_count;
+} mac_flow_t;
+
+/**
+ * @brief Scanner configuration; every string is copied by mac_scanner_init().
+ */
+typedef struct {
+    const char** api_urls;
+    size_t url_count;
+    size_t ring_buffer_size; ///< Ring buffer memory in bytes, a power of two
+    int poll_interval_ms;
+    const char* ca_cert_path;
+    int log_level;           ///< 0 debug, 1 info, 2 warn, 3 error
+    int use_syslog;
+    int drop_privileges;
+    const char* username;    ///< Account to switch to when drop_privileges is set
+    size_t flow_table_size;  ///< Flows aggregated at once, a power of two; 0 queues every pair unaggregated
+    int flow_flush_interval_ms; ///< How often aggregated flows are emitted; 0 for the default
+} mac_scanner_config_t;
+
+/**
+ * @brief Counters describing the scanner since initialization.
+ */
+typedef struct {
+    uint64_t packets_processed;
+    uint64_t buffer_fill;       ///< Pairs waiting in the ring buffer at the time of the snapshot
+    uint64_t buffer_full_count;
+    uint64_t requests_failed;
+    uint64_t error_count;
+    uint64_t flows_emitted;     ///< Flow records queued for mac_scanner_pop_flows()
+} mac_scanner_status_t;
+
+typedef struct mac_scanner mac_scanner_t;
+
+/**
+ * @brief Returns the library version string.
+ */
+EXPORT const char* mac_scanner_version(void);
+
+/**
+ * @brief Creates a scanner from @p config.
+ * @return The scanner, or NULL with a message in @p err_buf.
+ */
+EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char* err_buf, size_t err_buf_size);
+
+/**
+ * @brief Starts polling every configured URL from a single event loop thread.
+ * @return 0 when the loop is running (or already was), -1 on failure.
+ */
+EXPORT int mac_scanner_start(mac_scanner_t* scanner);
+
+/**
+ * @brief Stops polling and waits for the event loop to exit; buffered pairs can still be popped.
+ */
+EXPORT void mac_scanner_stop(mac_scanner_t* scanner);
+
+/**
+ * @brief Stops all polling and releases the scanner.
+ */
+EXPORT void mac_scanner_free(mac_scanner_t* scanner);
+
+/**
+ * @brief Fills @p status with a snapshot of the scanner counters.
+ * @note Lock-free for writers: polling threads are never delayed by a reader, however often it polls.
+ * @return 0 on success, -1 on invalid arguments.
+ */
+EXPORT int mac_scanner_get_status(mac_scanner_t* scanner, mac_scanner_status_t* status);
+
+/**
+ * @brief Takes the oldest pair off the ring buffer.
+ * @param timeout_ms How long to wait for a pair when the buffer is empty; 0 returns at once.
+ * @return 0 when @p pair was filled, -1 on timeout or shutdown.
+ * @warning Single consumer: at most one thread may pop from a scanner at a time.
+ */
+EXPORT int mac_scanner_pop(mac_scanner_t* scanner, mac_pair_t* pair, int timeout_ms);
+
+/**
+ * @brief Takes up to @p max pairs off the ring buffer in one call.
+ * @param timeout_ms How long to wait for the first pair when the buffer is empty; 0 returns at once.
+ * @return The number of pairs written to @p pairs, 0 on timeout or shutdown.
+ * @warning Single consumer, shared with mac_scanner_pop().
+ */
+EXPORT size_t mac_scanner_pop_batch(mac_scanner_t* scanner, mac_pair_t* pairs, size_t max, int timeout_ms);
+
+/**
+ * @brief Takes up to @p max flow records emitted by the aggregation table.
+ * @param timeout_ms How long to wait for the first flow when none are queued; 0 returns at once.
+ * @return The number of flows written to @p flows; always 0 when the scanner was created without a flow table.
+ * @note Pairs that were aggregated into flows are not also queued for mac_scanner_pop().
+ */
+EXPORT size_t mac_scanner_pop_flows(mac_scanner_t* scanner, mac_flow_t* flows, size_t max, int timeout_ms);
+
+/**
+ * @brief Writes the six octets of @p addr to @p mac.
+ * @note Takes the address by value so the mac_pair_t and mac_flow_t bit-fields can be passed directly.
+ */
+EXPORT void int_to_mac(mac_addr_t addr, uint8_t* mac);
+
+/**
+ * @brief Formats @p mac as "aa:bb:cc:dd:ee:ff".
+ * @return The length written, or -1 when @p size is below MAC_SCANNER_MAC_STRLEN.
+ */
+EXPORT int mac_scanner_format_mac(mac_addr_t mac, char* buf, size_t size);
+
+/**
+ * @brief Formats an IP from mac_pair_t in its usual text form; MAC_SCANNER_IP_NONE gives "".
+ * @return The length written, or -1 for an unknown family or when @p buf is too small
+ *         (MAC_SCANNER_IP_STRLEN always suffices).
+ */
+EXPORT int mac_scanner_format_ip(unsigned family, const uint8_t* ip, char* buf, size_t size);
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file packet_decoder.h
+ * @brief Incremental JSON decoder for MAC packet responses.
+ * @note Consumes a response in arbitrary chunks and decodes each packet object straight into a
+ *       mac_pair_t; no document tree is built and memory use does not grow with the response.
+ * @ingroup mac_scanner
+ */
+
+#ifndef PACKET_DECODER_H
+#define PACKET_DECODER_H
+
+#include "mac_scanner.h"
+
+#define PACKET_DECODER_MAX_DEPTH 64
+#define PACKET_DECODER_CAPTURE 64 ///< Longest string or number kept for a recognized key
+
+/**
+ * @brief Receives every packet that decoded with valid source and destination MACs.
+ */
+typedef void (*packet_sink_fn)(const mac_pair_t* pair, void* ctx);
+
+/**
+ * @brief Decoder state; one per in-flight response.
+ */
+typedef struct {
+    uint8_t state;
+    uint8_t return_state;  ///< State to resume after a string or literal completes
+    uint8_t depth;
+    uint8_t packet_depth;  ///< 1 for a bare object response, 2 for an array of objects, 0 until known
+    uint8_t field;         ///< Recognized key the next value belongs to
+    uint8_t string_is_key;
+    uint8_t overflow;      ///< Capture exceeded PACKET_DECODER_CAPTURE or held non-ASCII text
+    uint8_t unicode_digits;
+    uint16_t unicode;
+    uint8_t seen;          ///< Fields present in the current packet
+    uint8_t len;
+    uint8_t number;        ///< Position in the JSON number grammar while a number is read
+    uint64_t objects;      ///< Bit d set when the container at depth d + 1 is an object
+    char buf[PACKET_DECODER_CAPTURE];
+    mac_pair_t pair;
+    size_t consumed;
+    size_t packets;        ///< Valid packets handed to the sink
+    size_t invalid;        ///< Packet objects without a valid src_mac and dst_mac, plus non-object array elements
+    packet_sink_fn sink;
+    void* ctx;
+} packet_decoder_t;
+
+/**
+ * @brief Resets @p decoder for a new response.
+ */
+void packet_decoder_init(packet_decoder_t* decoder, packet_sink_fn sink, void* ctx);
+
+/**
+ * @brief Decodes the next @p len bytes of the response.
+ * @return 0, or -1 once the input is not valid JSON; later input is then ignored.
+ */
+int packet_decoder_feed(packet_decoder_t* decoder, const char* data, size_t len);
+
+/**
+ * @brief Checks that the response ended on a complete JSON value.
+ * @return 0 for a complete (or empty) response, -1 for malformed or truncated input.
+ */
+int packet_decoder_finish(const packet_decoder_t* decoder);
+
+#endif
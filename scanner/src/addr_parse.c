@@ -0,0 +1,268 @@
+#include "../include/addr_parse.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Nibble value with bit 4 set for every hex digit, 0 for everything else: AND-ing the entries of a whole
+// address keeps bit 4 only if each byte was a digit, so validation needs no per-byte branch
+#define HX(v) (0x10 | (v))
+static const uint8_t hex_lut[256] = {
+    ['0'] = HX(0), ['1'] = HX(1), ['2'] = HX(2), ['3'] = HX(3), ['4'] = HX(4),
+    ['5'] = HX(5), ['6'] = HX(6), ['7'] = HX(7), ['8'] = HX(8), ['9'] = HX(9),
+    ['a'] = HX(10), ['b'] = HX(11), ['c'] = HX(12), ['d'] = HX(13), ['e'] = HX(14), ['f'] = HX(15),
+    ['A'] = HX(10), ['B'] = HX(11), ['C'] = HX(12), ['D'] = HX(13), ['E'] = HX(14), ['F'] = HX(15),
+};
+#undef HX
+
+// Digit positions of the three accepted layouts
+static const uint8_t separated_digits[12] = { 0, 1, 3, 4, 6, 7, 9, 10, 12, 13, 15, 16 }; // aa:bb:cc:dd:ee:ff
+static const uint8_t dotted_digits[12] = { 0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13 };      // aabb.ccdd.eeff
+static const uint8_t bare_digits[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };         // aabbccddeeff
+
+static inline void mac_to_int(const uint8_t* mac, mac_addr_t* addr) {
+    *addr = (uint64_t)mac[0] << 40 | (uint64_t)mac[1] << 32 | (uint64_t)mac[2] << 24 |
+            (uint64_t)mac[3] << 16 | (uint64_t)mac[4] << 8 | (uint64_t)mac[5];
+}
+
+static inline int is_mac_separator(char c) {
+    return c == ':' || c == '-' || c == '.';
+}
+
+static int decode_digits(const char* str, const uint8_t* positions, mac_addr_t* addr) {
+    uint8_t mac[6];
+    unsigned valid = 0x10;
+    for (int i = 0; i < 6; i++) {
+        uint8_t hi = hex_lut[(unsigned char)str[positions[2 * i]]];
+        uint8_t lo = hex_lut[(unsigned char)str[positions[2 * i + 1]]];
+        valid &= hi & lo;
+        mac[i] = (uint8_t)(hi << 4 | (lo & 0x0F));
+    }
+    if (!valid) return -1;
+
+    mac_to_int(mac, addr);
+    return 0;
+}
+
+int parse_mac_scalar(const char* str, size_t len, mac_addr_t* addr) {
+    if (!str || !addr) return -1;
+
+    switch (len) {
+    case 17: {
+        // One separator, used consistently
+        char sep = str[2];
+        if (!is_mac_separator(sep) || str[5] != sep || str[8] != sep || str[11] != sep || str[14] != sep) return -1;
+        return decode_digits(str, separated_digits, addr);
+    }
+    case 14:
+        if (str[4] != '.' || str[9] != '.') return -1;
+        return decode_digits(str, dotted_digits, addr);
+    case 12:
+        return decode_digits(str, bare_digits, addr);
+    default:
+        return -1;
+    }
+}
+
+#if defined(__SSE2__)
+#define SSE2_HEX_POSITIONS 0xB6DBu // bytes 0-1, 3-4, 6-7, 9-10, 12-13 and 15 of the first 16
+#define SSE2_SEP_POSITIONS 0x4924u // bytes 2, 5, 8, 11 and 14
+
+// Classifies and converts the first 16 bytes of a separated MAC at once; byte 16 is the only one left to
+// the lookup table
+int parse_mac_sse2(const char* str, size_t len, mac_addr_t* addr) {
+    if (len != 17 || !str || !addr) return parse_mac_scalar(str, len, addr);
+
+    const char sep = str[2];
+    if (!is_mac_separator(sep)) return -1;
+
+    const __m128i v = _mm_loadu_si128((const __m128i*)str);
+    const __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    const __m128i alpha = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    const __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+    const unsigned hex = (unsigned)_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha));
+    const unsigned seps = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(sep)));
+    const uint8_t last = hex_lut[(unsigned char)str[16]];
+    if ((hex & SSE2_HEX_POSITIONS) != SSE2_HEX_POSITIONS || (seps & SSE2_SEP_POSITIONS) != SSE2_SEP_POSITIONS || !last) {
+        return -1;
+    }
+
+    // Byte p of the combined vector is nibble[p] << 4 | nibble[p + 1]; octets start at every third byte
+    const __m128i nibbles = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                                         _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+    const __m128i high = _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi8((char)0xF0));
+    uint8_t combined[16];
+    _mm_storeu_si128((__m128i*)combined, _mm_or_si128(high, _mm_srli_si128(nibbles, 1)));
+
+    const uint8_t mac[6] = {
+        combined[0], combined[3], combined[6], combined[9], combined[12],
+        (uint8_t)(combined[15] | (last & 0x0F))
+    };
+    mac_to_int(mac, addr);
+    return 0;
+}
+#endif
+
+int parse_mac_n(const char* str, size_t len, mac_addr_t* addr) {
+#if defined(__SSE2__)
+    return parse_mac_sse2(str, len, addr);
+#else
+    return parse_mac_scalar(str, len, addr);
+#endif
+}
+
+int parse_mac(const char* mac_str, mac_addr_t* addr) {
+    if (!mac_str) return -1;
+    return parse_mac_n(mac_str, strlen(mac_str), addr);
+}
+
+int parse_ipv4(const char* str, size_t len, uint8_t out[4]) {
+    if (!str || len < 7 || len > 15) return -1;
+
+    uint8_t octets[4];
+    unsigned value = 0, digits = 0, part = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned d = (unsigned char)str[i] - '0';
+        if (d <= 9) {
+            // "0" alone is fine, "01" is not
+            if (digits && value == 0) return -1;
+            value = value * 10 + d;
+            if (++digits > 3 || value > 255) return -1;
+        } else if (str[i] == '.') {
+            if (!digits || part == 3) return -1;
+            octets[part++] = (uint8_t)value;
+            value = 0;
+            digits = 0;
+        } else {
+            return -1;
+        }
+    }
+    if (!digits || part != 3) return -1;
+    octets[3] = (uint8_t)value;
+
+    memcpy(out, octets, 4);
+    return 0;
+}
+
+int parse_ipv6(const char* str, size_t len, uint8_t out[16]) {
+    if (!str || len < 2 || len > MAC_SCANNER_IP_STRLEN - 1) return -1;
+
+    uint8_t addr[16] = {0};
+    size_t i = 0, group_start = 0;
+    int filled = 0, gap = -1;
+    unsigned value = 0, digits = 0;
+
+    // A leading colon is only valid as the start of "::"
+    if (str[0] == ':') {
+        if (str[1] != ':') return -1;
+        i = group_start = 1;
+    }
+
+    for (; i < len; i++) {
+        const char c = str[i];
+        const uint8_t h = hex_lut[(unsigned char)c];
+        if (h) {
+            if (++digits > 4) return -1;
+            value = value << 4 | (h & 0x0F);
+            continue;
+        }
+        if (c == ':') {
+            group_start = i + 1;
+            if (!digits) {
+                if (gap >= 0) return -1;
+                gap = filled;
+                continue;
+            }
+            // A trailing single colon leaves an empty last group
+            if (i + 1 == len || filled + 2 > 16) return -1;
+            addr[filled++] = (uint8_t)(value >> 8);
+            addr[filled++] = (uint8_t)value;
+            value = 0;
+            digits = 0;
+            continue;
+        }
+        // The last 32 bits may be written as a dotted quad
+        if (c == '.' && filled + 4 <= 16) {
+            if (parse_ipv4(str + group_start, len - group_start, addr + filled) != 0) return -1;
+            filled += 4;
+            digits = 0;
+            break;
+        }
+        return -1;
+    }
+
+    if (digits) {
+        if (filled + 2 > 16) return -1;
+        addr[filled++] = (uint8_t)(value >> 8);
+        addr[filled++] = (uint8_t)value;
+    }
+
+    if (gap >= 0) {
+        // "::" stands for at least one zero group
+        if (filled == 16) return -1;
+        const int tail = filled - gap;
+        memmove(addr + 16 - tail, addr + gap, (size_t)tail);
+        memset(addr + gap, 0, (size_t)(16 - tail - gap));
+        filled = 16;
+    }
+    if (filled != 16) return -1;
+
+    memcpy(out, addr, 16);
+    return 0;
+}
+
+int parse_ip(const char* str, size_t len, uint8_t out[16]) {
+    if (!str) return -1;
+    if (memchr(str, ':', len)) return parse_ipv6(str, len, out) == 0 ? MAC_SCANNER_IP_V6 : -1;
+    return parse_ipv4(str, len, out) == 0 ? MAC_SCANNER_IP_V4 : -1;
+}
+
+EXPORT void int_to_mac(mac_addr_t addr, uint8_t* mac) {
+    if (!mac) return;
+    for (int i = 0; i < 6; i++) {
+        mac[i] = (uint8_t)(addr >> (40 - 8 * i));
+    }
+}
+
+EXPORT int mac_scanner_format_mac(mac_addr_t mac, char* buf, size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    if (!buf || size < MAC_SCANNER_MAC_STRLEN) return -1;
+
+    char* p = buf;
+    for (int shift = 40; shift >= 0; shift -= 8) {
+        *p++ = digits[(mac >> (shift + 4)) & 0x0F];
+        *p++ = digits[(mac >> shift) & 0x0F];
+        *p++ = ':';
+    }
+    p[-1] = 0;
+    return MAC_SCANNER_MAC_STRLEN - 1;
+}
+
+EXPORT int mac_scanner_format_ip(unsigned family, const uint8_t* ip, char* buf, size_t size) {
+    if (!buf || size == 0) return -1;
+
+    switch (family) {
+    case MAC_SCANNER_IP_NONE:
+        buf[0] = 0;
+        return 0;
+    case MAC_SCANNER_IP_V4:
+        if (!ip || !inet_ntop(AF_INET, ip, buf, size)) return -1;
+        break;
+    case MAC_SCANNER_IP_V6:
+        if (!ip || !inet_ntop(AF_INET6, ip, buf, size)) return -1;
+        break;
+    default:
+        return -1;
+    }
+    return (int)strlen(buf);
+}
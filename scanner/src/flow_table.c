@@ -0,0 +1,135 @@
+#include "../include/flow_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t hash;    // 0 marks an empty slot
+    uint64_t touched; // table clock at the last update, for picking an eviction victim
+    mac_flow_t flow;
+} flow_entry_t;
+
+struct flow_table {
+    flow_entry_t* entries;
+    size_t mask;
+    size_t used;
+    uint64_t clock;
+    uint64_t evictions;
+    flow_sink_fn sink;
+    void* ctx;
+};
+
+static inline uint64_t mix(uint64_t h, uint64_t v) {
+    h = (h ^ v) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+}
+
+static uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Never 0, so a stored hash also marks its slot as used
+static uint64_t hash_pair(const mac_pair_t* pair) {
+    uint64_t h = mix(0, (uint64_t)pair->src_mac | (uint64_t)pair->src_family << 48);
+    h = mix(h, (uint64_t)pair->dst_mac | (uint64_t)pair->dst_family << 48);
+    h = mix(h, load64(pair->src_ip));
+    h = mix(h, load64(pair->src_ip + 8));
+    h = mix(h, load64(pair->dst_ip));
+    h = mix(h, load64(pair->dst_ip + 8));
+    return h | 1;
+}
+
+static int same_flow(const mac_flow_t* flow, const mac_pair_t* pair) {
+    return flow->src_mac == pair->src_mac && flow->dst_mac == pair->dst_mac &&
+           flow->src_family == pair->src_family && flow->dst_family == pair->dst_family &&
+           memcmp(flow->src_ip, pair->src_ip, sizeof(flow->src_ip)) == 0 &&
+           memcmp(flow->dst_ip, pair->dst_ip, sizeof(flow->dst_ip)) == 0;
+}
+
+static void start_flow(flow_entry_t* entry, uint64_t hash, const mac_pair_t* pair) {
+    entry->hash = hash;
+    entry->flow.src_mac = pair->src_mac;
+    entry->flow.src_family = pair->src_family;
+    entry->flow.dst_mac = pair->dst_mac;
+    entry->flow.dst_family = pair->dst_family;
+    memcpy(entry->flow.src_ip, pair->src_ip, sizeof(entry->flow.src_ip));
+    memcpy(entry->flow.dst_ip, pair->dst_ip, sizeof(entry->flow.dst_ip));
+    entry->flow.first_seen_ns = pair->timestamp_ns;
+    entry->flow.last_seen_ns = pair->timestamp_ns;
+    entry->flow.packet_count = 1;
+}
+
+flow_table_t* flow_table_create(size_t capacity, flow_sink_fn sink, void* ctx) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return NULL;
+
+    flow_table_t* table = calloc(1, sizeof(*table));
+    if (!table) return NULL;
+    table->entries = calloc(capacity, sizeof(flow_entry_t));
+    if (!table->entries) {
+        free(table);
+        return NULL;
+    }
+    table->mask = capacity - 1;
+    table->sink = sink;
+    table->ctx = ctx;
+    return table;
+}
+
+// Entries are only ever replaced, never removed one at a time, so a flow always sits in its probe window
+// ahead of the first empty slot and lookups need no tombstones
+void flow_table_add(flow_table_t* table, const mac_pair_t* pair) {
+    const uint64_t hash = hash_pair(pair);
+    const size_t window = FLOW_TABLE_MAX_PROBE < table->mask + 1 ? FLOW_TABLE_MAX_PROBE : table->mask + 1;
+    flow_entry_t* victim = NULL;
+    table->clock++;
+
+    for (size_t i = 0; i < window; i++) {
+        flow_entry_t* entry = &table->entries[(hash + i) & table->mask];
+        if (entry->hash == 0) {
+            start_flow(entry, hash, pair);
+            entry->touched = table->clock;
+            table->used++;
+            return;
+        }
+        if (entry->hash == hash && same_flow(&entry->flow, pair)) {
+            mac_flow_t* flow = &entry->flow;
+            if (pair->timestamp_ns < flow->first_seen_ns) flow->first_seen_ns = pair->timestamp_ns;
+            if (pair->timestamp_ns > flow->last_seen_ns) flow->last_seen_ns = pair->timestamp_ns;
+            flow->packet_count++;
+            entry->touched = table->clock;
+            return;
+        }
+        if (!victim || entry->touched < victim->touched) victim = entry;
+    }
+
+    // Window full of other flows: the least recently updated one leaves early
+    table->evictions++;
+    if (table->sink) table->sink(&victim->flow, table->ctx);
+    start_flow(victim, hash, pair);
+    victim->touched = table->clock;
+}
+
+size_t flow_table_flush(flow_table_t* table) {
+    size_t emitted = 0;
+    for (size_t i = 0; i <= table->mask && emitted < table->used; i++) {
+        flow_entry_t* entry = &table->entries[i];
+        if (entry->hash == 0) continue;
+        if (table->sink) table->sink(&entry->flow, table->ctx);
+        entry->hash = 0;
+        emitted++;
+    }
+    table->used = 0;
+    return emitted;
+}
+
+uint64_t flow_table_evictions(const flow_table_t* table) {
+    return table->evictions;
+}
+
+void flow_table_free(flow_table_t* table) {
+    if (!table) return;
+    free(table->entries);
+    free(table);
+}
@@ -1,5 +1,9 @@
-#include "../include//mac_scanner.h"
+#include "../include/mac_scanner.h"
+#include "../include/packet_decoder.h"
+#include "../include/flow_table.h"
 
+#include <stdalign.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,9 +14,9 @@
 #include <syslog.h>
 #include <sys/prctl.h>
 #include <pwd.h>
+#include <grp.h>
 #include <signal.h>
 #include <curl/curl.h>
-#include <cjson/cJSON.h>
 #include <stdatomic.h>
 #include <sys/resource.h>
 
@@ -26,8 +30,12 @@
 #include <sys/stat.h>
 #endif
 
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
 #define RING_BUFFER_SIZE (1 << 16)
-#define MAX_RESPONSE_SIZE 8192
 #define MAX_THREAD_RETRIES 3
 #define CONNECTION_TIMEOUT_MS 10000
 #define SSL_CIPHER_LIST "HIGH:!aNULL:!MD5:!RC4"
@@ -35,6 +43,15 @@
 #define MAX_POLL_INTERVAL_MS 60000
 #define MIN_POLL_INTERVAL_MS 100
 #define MAC_SCANNER_VERSION "1.0.1"
+#define CACHE_LINE_SIZE 64
+#define PUSH_BATCH_SIZE 256
+#define STATUS_SHARDS 16
+#define WHEEL_SLOTS 1024            // power of two
+#define WHEEL_TICK_MS 10
+#define MAX_CONCURRENT_TRANSFERS 1024
+#define INITIAL_BACKOFF_MS 100
+#define DEFAULT_FLOW_FLUSH_MS 5000
+#define MAX_FLOW_TABLE_SIZE (1 << 24)
 
 #define THREAD_LOCAL __thread
 
@@ -45,11 +62,10 @@
 
 #define SAFE_FREE(ptr) do { if (ptr) { free(ptr); ptr = NULL; } } while(0)
 
-static void cleanup_thread_resources(void* arg);
 
 static atomic_int log_level = LOG_LEVEL_INFO;
 static atomic_int use_syslog = 0;
-static atomic_int sig_atomic_t running = 1;
+static atomic_int running = 1;
 
 void init_logger(int level, int syslog_enabled) {
     atomic_store(&log_level, level);
@@ -102,71 +118,149 @@ static void handle_signal(int sig) {
     }
 }
 
+// Slot sequence numbers (Vyukov): seq == pos means free for the producer claiming pos,
+// seq == pos + 1 means published for the consumer, seq == pos + size means free for the next lap
+typedef struct {
+    alignas(CACHE_LINE_SIZE) _Atomic size_t sequence;
+    mac_pair_t pair;
+} ring_slot_t;
+
+_Static_assert(sizeof(ring_slot_t) == CACHE_LINE_SIZE, "a ring slot should fill exactly one cache line");
+
+// Lock-free multi-producer/single-consumer ring; each cursor sits on its own cache line
 typedef struct {
-    mac_pair_t* buffer;
-    _Atomic size_t head, tail;
+    alignas(CACHE_LINE_SIZE) _Atomic size_t head;          // next position to claim, shared by producers
+    alignas(CACHE_LINE_SIZE) _Atomic size_t tail;          // next position to read, consumer only
+    alignas(CACHE_LINE_SIZE) _Atomic uint32_t consumer_idle; // futex word: 1 while the consumer sleeps
+    ring_slot_t* slots;
     size_t size;
-    pthread_mutex_t mutex;
-    pthread_cond_t not_empty;
-    pthread_cond_t not_full;
+    size_t mask;
     _Atomic int running;
 } ring_buffer_t;
 
+enum {
+    STATUS_PACKETS_PROCESSED,
+    STATUS_BUFFER_FULL,
+    STATUS_REQUESTS_FAILED,
+    STATUS_ERRORS,
+    STATUS_FLOWS_EMITTED,
+    STATUS_COUNTER_COUNT
+};
+
+// One cache line of counters; seq is odd while a writer is mid-update
+typedef struct {
+    alignas(CACHE_LINE_SIZE) _Atomic uint32_t seq;
+    _Atomic uint64_t counters[STATUS_COUNTER_COUNT];
+} status_shard_t;
+
+// Decoded pairs waiting to be pushed to the ring together
+typedef struct {
+    mac_pair_t pairs[PUSH_BATCH_SIZE];
+    size_t count;
+} packet_batch_t;
+
+// Flows emitted by the event loop and queued together
+typedef struct {
+    mac_flow_t flows[PUSH_BATCH_SIZE];
+    size_t count;
+} flow_batch_t;
+
+// Flows waiting for mac_scanner_pop_flows(); at most a table's worth per flush interval, so unlike the
+// pair ring a mutex (the scanner's) is cheap enough here
+typedef struct {
+    mac_flow_t* flows;
+    size_t capacity;          // power of two
+    size_t head;
+    size_t count;
+    int closed;               // set on free, wakes a waiting consumer for good
+    pthread_cond_t ready;
+} flow_queue_t;
+
+// Per-URL poll state; the event loop owns it, so none of it needs atomics
+typedef struct {
+    CURL* easy;               // created on the first poll and reused, NULL until then
+    packet_decoder_t decoder; // decodes the response as it arrives
+    uint64_t due_tick;        // wheel tick of the next poll
+    uint64_t last_success_s;  // CLOCK_MONOTONIC seconds
+    uint32_t backoff_ms;
+    uint32_t consecutive_errors;
+    int32_t wheel_next;       // next URL index in the same wheel slot, -1 at the end
+    uint8_t in_flight;
+} url_state_t;
+
+// Hashed timing wheel: a URL due at tick t waits in slot t % WHEEL_SLOTS, possibly for several laps
+typedef struct {
+    int32_t slots[WHEEL_SLOTS]; // first URL index in each slot, -1 when empty
+    uint64_t tick;              // next tick to expire
+    uint64_t start_ns;
+} timer_wheel_t;
+
 struct mac_scanner {
     CURLM* curl_multi;
-    pthread_t* polling_threads;
+    pthread_t loop_thread;
+    _Atomic int loop_started;
+    url_state_t* urls;
+    packet_batch_t* batch;    // owned by the event loop
+    flow_table_t* flow_table; // owned by the event loop; NULL when pairs go to the ring unaggregated
+    flow_batch_t* flow_batch;
+    size_t aggregated;        // pairs added to the flow table since the last status update
+    uint64_t flow_flush_interval_ns;
+    uint64_t next_flow_flush_ns;
+    timer_wheel_t wheel;
+    size_t in_flight;
     size_t url_count;
     char** api_urls;  // Owned copies, not just pointers
     ring_buffer_t ring_buffer;
     _Atomic int active;
-    pthread_mutex_t mutex;
-    pthread_rwlock_t status_lock;
-    mac_scanner_status_t status;
+    pthread_mutex_t mutex;    // guards flow_queue
+    flow_queue_t flow_queue;
+    status_shard_t status_shards[STATUS_SHARDS];
     int poll_interval_ms;
     char* ca_cert_path;  // Owned copy
     _Atomic int shutdown_requested;
     _Atomic uint64_t last_error_time;
-    _Atomic size_t active_thread_count;
     char* version;
 };
 
-// HTTP response buffer with improved memory safety
-typedef struct {
-    char* data;
-    size_t size;
-    size_t capacity;
-} response_t;
-
-// Thread context with retry capability
-typedef struct {
-    mac_scanner_t* scanner;
-    size_t index;
-    int retries;
-    pthread_t thread_id;
-    _Atomic int active;
-    char* url;
-} thread_context_t;
+// Threads spread over the shards round-robin, so writers rarely share a line
+static atomic_uint next_status_shard;
+static THREAD_LOCAL unsigned status_shard_slot; // shard index + 1, 0 until first use
 
-// Utility functions
-static inline void mac_to_int(const uint8_t* mac, mac_addr_t* addr) {
-    if (!mac || !addr) return;
+// Enters the calling thread's shard as its writer; pair with status_end()
+static status_shard_t* status_begin(mac_scanner_t* scanner) {
+    if (status_shard_slot == 0) {
+        status_shard_slot = atomic_fetch_add_explicit(&next_status_shard, 1, memory_order_relaxed) % STATUS_SHARDS + 1;
+    }
+    status_shard_t* shard = &scanner->status_shards[status_shard_slot - 1];
+
+    // Only threads mapped to the same shard can meet here; spin until the other writer is done
+    uint32_t seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    for (;;) {
+        if ((seq & 1) == 0 &&
+            atomic_compare_exchange_weak_explicit(&shard->seq, &seq, seq + 1,
+                                                  memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+        seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    }
+    atomic_thread_fence(memory_order_release);
+    return shard;
+}
 
-    addr->mac_high = ((uint32_t)mac[0] << 24) |
-                     ((uint32_t)mac[1] << 16) |
-                     ((uint32_t)mac[2] << 8) |
-                      (uint32_t)mac[3];
-    addr->mac_low = ((uint16_t)mac[4] << 8) | (uint16_t)mac[5];
+static inline void status_count(status_shard_t* shard, int counter, uint64_t n) {
+    atomic_store_explicit(&shard->counters[counter],
+                          atomic_load_explicit(&shard->counters[counter], memory_order_relaxed) + n,
+                          memory_order_relaxed);
 }
 
-EXPORT void int_to_mac(const mac_addr_t* addr, uint8_t* mac) {
-    if (!addr || !mac) return;
+static void status_end(status_shard_t* shard) {
+    atomic_fetch_add_explicit(&shard->seq, 1, memory_order_release);
+}
 
-    mac[0] = (addr->mac_high >> 24) & 0xFF;
-    mac[1] = (addr->mac_high >> 16) & 0xFF;
-    mac[2] = (addr->mac_high >> 8) & 0xFF;
-    mac[3] = addr->mac_high & 0xFF;
-    mac[4] = (addr->mac_low >> 8) & 0xFF;
-    mac[5] = addr->mac_low & 0xFF;
+static void status_add(mac_scanner_t* scanner, int counter, uint64_t n) {
+    status_shard_t* shard = status_begin(scanner);
+    status_count(shard, counter, n);
+    status_end(shard);
 }
 
 // Safe string copy with bounds checking
@@ -253,40 +347,13 @@ static char* secure_strdup(const char* str) {
     return dup;
 }
 
-// Enhanced curl write callback with bounds checking
+// Feeds each chunk straight to the URL's decoder; nothing of the response is buffered
 static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     size_t realsize = size * nmemb;
-    response_t* resp = (response_t*)userp;
+    packet_decoder_t* decoder = (packet_decoder_t*)userp;
 
-    // Check for overflow
-    if (resp->size + realsize < resp->size) {
-        log_message(LOG_LEVEL_ERROR, "Integer overflow in response size");
-        return 0;
-    }
-
-    // Check if we need to expand capacity
-    if (resp->size + realsize + 1 > resp->capacity) {
-        size_t new_capacity = resp->capacity ? resp->capacity * 2 : MAX_RESPONSE_SIZE;
-        while (new_capacity < resp->size + realsize + 1) {
-            if (new_capacity > SIZE_MAX / 2) {
-                log_message(LOG_LEVEL_ERROR, "Response too large");
-                return 0;
-            }
-            new_capacity *= 2;
-        }
-
-        char* ptr = realloc(resp->data, new_capacity);
-        if (!ptr) {
-            log_message(LOG_LEVEL_ERROR, "Memory allocation failed for response buffer");
-            return 0;
-        }
-        resp->data = ptr;
-        resp->capacity = new_capacity;
-    }
-
-    memcpy(&(resp->data[resp->size]), contents, realsize);
-    resp->size += realsize;
-    resp->data[resp->size] = 0;
+    // After a syntax error the rest of the body is read and ignored; the error is reported on completion
+    packet_decoder_feed(decoder, contents, realsize);
     return realsize;
 }
 
@@ -298,202 +365,221 @@ static int init_ring_buffer(ring_buffer_t* rb, size_t size) {
     }
 
 #ifdef _WIN32
-    rb->buffer = VirtualAlloc(NULL, size * sizeof(mac_pair_t),
+    rb->slots = VirtualAlloc(NULL, size * sizeof(ring_slot_t),
                             MEM_COMMIT | MEM_RESERVE,
                             PAGE_READWRITE);
-    if (!rb->buffer) {
+    if (!rb->slots) {
         log_message(LOG_LEVEL_ERROR, "VirtualAlloc failed: %lu", GetLastError());
         return -1;
     }
 #else
-    rb->buffer = mmap(NULL, size * sizeof(mac_pair_t),
+    rb->slots = mmap(NULL, size * sizeof(ring_slot_t),
                      PROT_READ | PROT_WRITE,
                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (rb->buffer == MAP_FAILED) {
+    if (rb->slots == MAP_FAILED) {
+        rb->slots = NULL;
         log_message(LOG_LEVEL_ERROR, "mmap failed: %s", strerror(errno));
         return -1;
     }
 
     // Lock memory to prevent paging to swap
-    if (mlock(rb->buffer, size * sizeof(mac_pair_t)) != 0) {
+    if (mlock(rb->slots, size * sizeof(ring_slot_t)) != 0) {
         log_message(LOG_LEVEL_WARN, "Could not lock memory: %s", strerror(errno));
     }
 #endif
 
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&rb->slots[i].sequence, i);
+    }
+
     rb->size = size;
+    rb->mask = size - 1;
     atomic_store(&rb->head, 0);
     atomic_store(&rb->tail, 0);
-    atomic_store(&rb->running, 0);
-
-    pthread_mutexattr_t mutex_attr;
-    pthread_mutexattr_init(&mutex_attr);
-    pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutex_init(&rb->mutex, &mutex_attr);
-    pthread_mutexattr_destroy(&mutex_attr);
-
-    pthread_condattr_t cond_attr;
-    pthread_condattr_init(&cond_attr);
-    pthread_cond_init(&rb->not_empty, &cond_attr);
-    pthread_cond_init(&rb->not_full, &cond_attr);
-    pthread_condattr_destroy(&cond_attr);
+    atomic_store(&rb->consumer_idle, 0);
+    atomic_store(&rb->running, 1);
 
     return 0;
 }
 
-// Push to ring buffer with improved thread safety
-static int push_ring_buffer(ring_buffer_t* rb, const mac_pair_t* mac, mac_scanner_t* scanner) {
-    if (!rb || !mac || !scanner) {
-        return -1;
-    }
+static void destroy_ring_buffer(ring_buffer_t* rb) {
+    if (!rb->slots) return;
 
-    int result = -1;
-    pthread_mutex_lock(&rb->mutex);
+#ifdef _WIN32
+    VirtualFree(rb->slots, 0, MEM_RELEASE);
+#else
+    munlock(rb->slots, rb->size * sizeof(ring_slot_t));
+    munmap(rb->slots, rb->size * sizeof(ring_slot_t));
+#endif
+    rb->slots = NULL;
+}
 
-    // Wait for space if buffer is full
-    size_t next_head = (atomic_load(&rb->head) + 1) & (rb->size - 1);
-    while (next_head == atomic_load(&rb->tail) && atomic_load(&rb->running)) {
-        struct timespec timeout;
-        clock_gettime(CLOCK_REALTIME, &timeout);
-        timeout.tv_sec += 1; // 1 second timeout
+// Sleeps while *word == expected, at most timeout_ms; returns early on wake or spuriously
+static void ring_wait(_Atomic uint32_t* word, uint32_t expected, int timeout_ms) {
+#ifdef __linux__
+    struct timespec timeout = { timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, &timeout, NULL, 0);
+#else
+    // No futex: poll in short slices
+    (void)word;
+    (void)expected;
+    usleep((timeout_ms < 1 ? 1 : timeout_ms > 10 ? 10 : timeout_ms) * 1000);
+#endif
+}
 
-        int rc = pthread_cond_timedwait(&rb->not_full, &rb->mutex, &timeout);
-        if (rc == ETIMEDOUT) {
-            pthread_rwlock_wrlock(&scanner->status_lock);
-            scanner->status.buffer_full_count++;
-            pthread_rwlock_unlock(&scanner->status_lock);
-            break;
-        }
+static void ring_wake(_Atomic uint32_t* word) {
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
 
-        next_head = (atomic_load(&rb->head) + 1) & (rb->size - 1);
+// Wakes the consumer, but only pays for the syscall when it is actually asleep
+static void ring_notify_consumer(ring_buffer_t* rb) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&rb->consumer_idle, memory_order_relaxed) &&
+        atomic_exchange_explicit(&rb->consumer_idle, 0, memory_order_relaxed)) {
+        ring_wake(&rb->consumer_idle);
     }
+}
 
-    if (next_head != atomic_load(&rb->tail) || !atomic_load(&rb->running)) {
-        // Copy data with memory barrier for thread safety
-        memcpy(&rb->buffer[atomic_load(&rb->head)], mac, sizeof(mac_pair_t));
-        atomic_store(&rb->head, next_head);
-
-        pthread_rwlock_wrlock(&scanner->status_lock);
-        scanner->status.packets_processed++;
-        scanner->status.buffer_fill = (atomic_load(&rb->head) >= atomic_load(&rb->tail)) ?
-                                     atomic_load(&rb->head) - atomic_load(&rb->tail) :
-                                     rb->size - atomic_load(&rb->tail) + atomic_load(&rb->head);
-        pthread_rwlock_unlock(&scanner->status_lock);
-
-        pthread_cond_signal(&rb->not_empty);
-        result = 0;
-    } else {
-        pthread_rwlock_wrlock(&scanner->status_lock);
-        scanner->status.requests_failed++;
-        pthread_rwlock_unlock(&scanner->status_lock);
-    }
+// Stops waits on the ring; pairs already published can still be popped
+static void shutdown_ring_buffer(ring_buffer_t* rb) {
+    atomic_store(&rb->running, 0);
+    atomic_store(&rb->consumer_idle, 0);
+    ring_wake(&rb->consumer_idle);
+}
 
-    pthread_mutex_unlock(&rb->mutex);
-    return result;
+// Entries published and not yet popped
+static size_t ring_buffer_fill(ring_buffer_t* rb) {
+    size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    return head - tail <= rb->size ? head - tail : 0;
 }
 
-// Pop from ring buffer with timeout support
-static int pop_ring_buffer(ring_buffer_t* rb, mac_pair_t* mac, int timeout_ms) {
-    if (!rb || !mac) {
-        return -1;
+// Push a batch with one reservation; never blocks, pairs that do not fit a full ring are dropped.
+// Returns how many of the count pairs were pushed.
+static size_t push_ring_buffer_batch(ring_buffer_t* rb, const mac_pair_t* pairs, size_t count, mac_scanner_t* scanner) {
+    if (!rb || !pairs || !scanner || !rb->slots || count == 0) {
+        return 0;
     }
 
-    int result = -1;
-    pthread_mutex_lock(&rb->mutex);
-
-    // Wait for data if buffer is empty
-    if (atomic_load(&rb->head) == atomic_load(&rb->tail) && atomic_load(&rb->running)) {
-        if (timeout_ms > 0) {
-            struct timespec timeout;
-            clock_gettime(CLOCK_REALTIME, &timeout);
-            timeout.tv_sec += timeout_ms / 1000;
-            timeout.tv_nsec += (timeout_ms % 1000) * 1000000;
-            if (timeout.tv_nsec >= 1000000000) {
-                timeout.tv_sec++;
-                timeout.tv_nsec -= 1000000000;
+    size_t n;
+    size_t pos = atomic_load_explicit(&rb->head, memory_order_relaxed);
+    for (;;) {
+        // Free space as of the consumer's last release; tail never passes a published slot
+        size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+        size_t space = tail + rb->size - pos;
+        n = count < space ? count : space;
+        if (space > rb->size || n == 0) {
+            // Stale pos from before another producer's claim, or a full ring
+            size_t fresh = atomic_load_explicit(&rb->head, memory_order_relaxed);
+            if (fresh != pos) {
+                pos = fresh;
+                continue;
             }
+            n = 0;
+            break;
+        }
 
-            while (atomic_load(&rb->head) == atomic_load(&rb->tail) && atomic_load(&rb->running)) {
-                int rc = pthread_cond_timedwait(&rb->not_empty, &rb->mutex, &timeout);
-                if (rc == ETIMEDOUT) {
-                    break;
-                }
-            }
+        // The consumer frees slots in order, so the last slot being free means the whole range is
+        ring_slot_t* last = &rb->slots[(pos + n - 1) & rb->mask];
+        if (atomic_load_explicit(&last->sequence, memory_order_acquire) != pos + n - 1) {
+            pos = atomic_load_explicit(&rb->head, memory_order_relaxed);
+            continue;
+        }
+        if (atomic_compare_exchange_weak_explicit(&rb->head, &pos, pos + n,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            break;
         }
     }
 
-    if (atomic_load(&rb->head) != atomic_load(&rb->tail)) {
-        // Copy data with memory barrier for thread safety
-        memcpy(mac, &rb->buffer[atomic_load(&rb->tail)], sizeof(mac_pair_t));
-        atomic_store(&rb->tail, (atomic_load(&rb->tail) + 1) & (rb->size - 1));
-
-        pthread_cond_signal(&rb->not_full);
-        result = 0;
+    for (size_t i = 0; i < n; i++) {
+        ring_slot_t* slot = &rb->slots[(pos + i) & rb->mask];
+        memcpy(&slot->pair, &pairs[i], sizeof(mac_pair_t));
+        atomic_store_explicit(&slot->sequence, pos + i + 1, memory_order_release);
     }
-
-    pthread_mutex_unlock(&rb->mutex);
-    return result;
-}
-
-// Parse MAC address with validation
-static int parse_mac(const char* mac_str, mac_addr_t* addr) {
-    if (!mac_str || !addr) {
-        return -1;
+    if (n > 0) {
+        ring_notify_consumer(rb);
     }
 
-    // Validate MAC format with strict pattern checking
-    unsigned int values[6] = {0};
-    int items = sscanf(mac_str, "%x:%x:%x:%x:%x:%x",
-                      &values[0], &values[1], &values[2],
-                      &values[3], &values[4], &values[5]);
+    status_shard_t* shard = status_begin(scanner);
+    status_count(shard, STATUS_PACKETS_PROCESSED, n);
+    status_count(shard, STATUS_BUFFER_FULL, count - n);
+    status_end(shard);
 
-    if (items != 6) {
-        return -1;
-    }
+    return n;
+}
 
-    // Validate each byte is in range
-    for (int i = 0; i < 6; i++) {
-        if (values[i] > 0xFF) {
-            return -1;
+// Takes up to max published pairs and releases their slots with one tail update; single consumer only
+static size_t try_pop_ring_buffer_batch(ring_buffer_t* rb, mac_pair_t* pairs, size_t max) {
+    size_t pos = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+    size_t n = 0;
+
+    for (; n < max; n++) {
+        ring_slot_t* slot = &rb->slots[(pos + n) & rb->mask];
+        if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != pos + n + 1) {
+            break;
         }
+        memcpy(&pairs[n], &slot->pair, sizeof(mac_pair_t));
+        atomic_store_explicit(&slot->sequence, pos + n + rb->size, memory_order_release);
     }
 
-    // Convert to binary format
-    uint8_t mac[6];
-    for (int i = 0; i < 6; i++) {
-        mac[i] = (uint8_t)values[i];
+    if (n > 0) {
+        atomic_store_explicit(&rb->tail, pos + n, memory_order_relaxed);
     }
-
-    mac_to_int(mac, addr);
-    return 0;
+    return n;
 }
 
-// Validate IP address format
-static int validate_ip(const char* ip_str) {
-    if (!ip_str) return 0;
-
-    // Simple validation of IPv4 and IPv6
-    struct sockaddr_in sa4;
-    struct sockaddr_in6 sa6;
+// Pop up to max pairs, waiting up to timeout_ms while the buffer is empty; returns the number taken
+static size_t pop_ring_buffer_batch(ring_buffer_t* rb, mac_pair_t* pairs, size_t max, int timeout_ms) {
+    if (!rb || !pairs || !rb->slots || max == 0) {
+        return 0;
+    }
 
-    if (inet_pton(AF_INET, ip_str, &(sa4.sin_addr)) == 1) {
-        return 1; // Valid IPv4
+    size_t n = try_pop_ring_buffer_batch(rb, pairs, max);
+    if (n > 0 || timeout_ms <= 0) {
+        return n;
     }
 
-    if (inet_pton(AF_INET6, ip_str, &(sa6.sin6_addr)) == 1) {
-        return 1; // Valid IPv6
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t deadline_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec +
+                           (uint64_t)timeout_ms * 1000000ULL;
+
+    while (atomic_load(&rb->running)) {
+        // Announce the sleep before the final check, so a producer publishing in between sees it
+        atomic_store(&rb->consumer_idle, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        n = try_pop_ring_buffer_batch(rb, pairs, max);
+        if (n > 0) {
+            atomic_store(&rb->consumer_idle, 0);
+            return n;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+        if (now_ns >= deadline_ns) {
+            break;
+        }
+
+        int remaining_ms = (int)((deadline_ns - now_ns + 999999) / 1000000);
+        ring_wait(&rb->consumer_idle, 1, remaining_ms);
     }
 
-    return 0; // Invalid IP
+    atomic_store(&rb->consumer_idle, 0);
+    return try_pop_ring_buffer_batch(rb, pairs, max);
 }
 
 // Configure curl handle securely
-static void configure_curl_handle(CURL* curl, const char* url, response_t* response,
+static void configure_curl_handle(CURL* curl, const char* url, packet_decoder_t* decoder,
                                  const char* ca_cert_path, int timeout_ms) {
-    if (!curl || !url || !response) return;
+    if (!curl || !url || !decoder) return;
 
     curl_easy_setopt(curl, CURLOPT_URL, url);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, response);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, decoder);
 
     // Security settings
     curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
@@ -517,121 +603,368 @@ static void configure_curl_handle(CURL* curl, const char* url, response_t* respo
     curl_easy_setopt(curl, CURLOPT_USERAGENT, "MAC-Scanner/" MAC_SCANNER_VERSION);
 
     // Error buffer
-    THREAD_LOCAL char error_buffer[CURL_ERROR_SIZE];
+    static THREAD_LOCAL char error_buffer[CURL_ERROR_SIZE];
     curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error_buffer);
 }
 
-// Process JSON packet safely
-static void process_json_packet(cJSON* packet, mac_scanner_t* scanner) {
-    if (!packet || !scanner) return;
+static void flush_packet_batch(packet_batch_t* batch, mac_scanner_t* scanner) {
+    if (batch->count == 0) return;
 
-    cJSON* src_mac = cJSON_GetObjectItem(packet, "src_mac");
-    cJSON* dst_mac = cJSON_GetObjectItem(packet, "dst_mac");
-    cJSON* src_ip = cJSON_GetObjectItem(packet, "src_ip");
-    cJSON* dst_ip = cJSON_GetObjectItem(packet, "dst_ip");
-    cJSON* timestamp = cJSON_GetObjectItem(packet, "timestamp");
+    size_t pushed = push_ring_buffer_batch(&scanner->ring_buffer, batch->pairs, batch->count, scanner);
+    if (pushed < batch->count) {
+        log_message(LOG_LEVEL_DEBUG, "Ring buffer full, dropped %zu of %zu packets",
+                   batch->count - pushed, batch->count);
+    }
+    batch->count = 0;
+}
 
-    // Validate required fields
-    if (!cJSON_IsString(src_mac) || !cJSON_IsString(dst_mac)) {
-        pthread_rwlock_wrlock(&scanner->status_lock);
-        scanner->status.error_count++;
-        pthread_rwlock_unlock(&scanner->status_lock);
-        return;
+// Moves the batched flows to the consumer queue under one lock; flows that do not fit are dropped
+static void flush_flow_batch(mac_scanner_t* scanner) {
+    flow_batch_t* batch = scanner->flow_batch;
+    flow_queue_t* queue = &scanner->flow_queue;
+    if (batch->count == 0) return;
+
+    pthread_mutex_lock(&scanner->mutex);
+    size_t room = queue->capacity - queue->count;
+    size_t n = batch->count < room ? batch->count : room;
+    for (size_t i = 0; i < n; i++) {
+        queue->flows[(queue->head + queue->count + i) & (queue->capacity - 1)] = batch->flows[i];
     }
+    queue->count += n;
+    if (n > 0) {
+        pthread_cond_signal(&queue->ready);
+    }
+    pthread_mutex_unlock(&scanner->mutex);
+
+    status_shard_t* shard = status_begin(scanner);
+    status_count(shard, STATUS_FLOWS_EMITTED, n);
+    status_count(shard, STATUS_BUFFER_FULL, batch->count - n);
+    status_end(shard);
+
+    if (n < batch->count) {
+        log_message(LOG_LEVEL_DEBUG, "Flow queue full, dropped %zu of %zu flows", batch->count - n, batch->count);
+    }
+    batch->count = 0;
+}
+
+// Flow table sink: runs on the event loop for every flushed or evicted flow
+static void queue_flow(const mac_flow_t* flow, void* ctx) {
+    mac_scanner_t* scanner = (mac_scanner_t*)ctx;
+    flow_batch_t* batch = scanner->flow_batch;
+
+    batch->flows[batch->count++] = *flow;
+    if (batch->count == PUSH_BATCH_SIZE) {
+        flush_flow_batch(scanner);
+    }
+}
 
-    mac_pair_t pair = {0};
-    if (parse_mac(src_mac->valuestring, &pair.src_mac) < 0 ||
-        parse_mac(dst_mac->valuestring, &pair.dst_mac) < 0) {
-        pthread_rwlock_wrlock(&scanner->status_lock);
-        scanner->status.error_count++;
-        pthread_rwlock_unlock(&scanner->status_lock);
+// Decoder sink: aggregates a pair into its flow, or queues it and pushes the batch once it is full
+static void queue_pair(const mac_pair_t* pair, void* ctx) {
+    mac_scanner_t* scanner = (mac_scanner_t*)ctx;
+    packet_batch_t* batch = scanner->batch;
+
+    if (scanner->flow_table) {
+        flow_table_add(scanner->flow_table, pair);
+        scanner->aggregated++;
         return;
     }
 
-    // Get timestamp (prefer provided, fall back to current time)
+    batch->pairs[batch->count++] = *pair;
+    if (batch->count == PUSH_BATCH_SIZE) {
+        flush_packet_batch(batch, scanner);
+    }
+}
+
+static uint64_t monotonic_ns(void) {
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    pair.timestamp_ns = timestamp && cJSON_IsNumber(timestamp) ?
-                       (uint64_t)(timestamp->valuedouble * 1000000000.0) :
-                       ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
 
-    // Copy IP addresses if provided and valid
-    if (src_ip && cJSON_IsString(src_ip) && validate_ip(src_ip->valuestring)) {
-        safe_strncpy(pair.src_ip, src_ip->valuestring, sizeof(pair.src_ip));
+// Accounts for aggregated pairs and emits every flow once the flush interval has passed, or at once when forced
+static void flush_flows(mac_scanner_t* scanner, int force) {
+    if (!scanner->flow_table) return;
+
+    if (scanner->aggregated > 0) {
+        status_add(scanner, STATUS_PACKETS_PROCESSED, scanner->aggregated);
+        scanner->aggregated = 0;
+    }
+
+    uint64_t now = monotonic_ns();
+    if (force || now >= scanner->next_flow_flush_ns) {
+        size_t flows = flow_table_flush(scanner->flow_table);
+        scanner->next_flow_flush_ns = now + scanner->flow_flush_interval_ns;
+        if (flows > 0) {
+            log_message(LOG_LEVEL_DEBUG, "Flushed %zu flows (%llu evicted early so far)",
+                       flows, (unsigned long long)flow_table_evictions(scanner->flow_table));
+        }
+    }
+
+    // Evicted flows are batched as they happen, whether or not the table was flushed
+    flush_flow_batch(scanner);
+}
+
+static uint64_t wheel_now(const timer_wheel_t* wheel) {
+    return (monotonic_ns() - wheel->start_ns) / (WHEEL_TICK_MS * 1000000ULL);
+}
+
+static void wheel_init(timer_wheel_t* wheel) {
+    for (size_t i = 0; i < WHEEL_SLOTS; i++) {
+        wheel->slots[i] = -1;
+    }
+    wheel->tick = 0;
+    wheel->start_ns = monotonic_ns();
+}
+
+// Schedules URL index after delay_ms from now; never earlier than the next tick
+static void wheel_schedule(mac_scanner_t* scanner, size_t index, uint64_t delay_ms) {
+    timer_wheel_t* wheel = &scanner->wheel;
+    url_state_t* url = &scanner->urls[index];
+
+    uint64_t due = wheel_now(wheel) + (delay_ms + WHEEL_TICK_MS - 1) / WHEEL_TICK_MS;
+    if (due < wheel->tick) due = wheel->tick;
+    url->due_tick = due;
+
+    int32_t* head = &wheel->slots[due & (WHEEL_SLOTS - 1)];
+    url->wheel_next = *head;
+    *head = (int32_t)index;
+}
+
+// Hands a due URL to the multi handle; returns -1 if it could not be started
+static int start_transfer(mac_scanner_t* scanner, size_t index) {
+    url_state_t* url = &scanner->urls[index];
+
+    if (!url->easy) {
+        url->easy = curl_easy_init();
+        if (!url->easy) {
+            log_message(LOG_LEVEL_ERROR, "CURL init failed for %s", scanner->api_urls[index]);
+            status_add(scanner, STATUS_ERRORS, 1);
+            return -1;
+        }
+        configure_curl_handle(url->easy, scanner->api_urls[index], &url->decoder,
+                              scanner->ca_cert_path, scanner->poll_interval_ms);
+        curl_easy_setopt(url->easy, CURLOPT_PRIVATE, (void*)(uintptr_t)index);
     }
 
-    if (dst_ip && cJSON_IsString(dst_ip) && validate_ip(dst_ip->valuestring)) {
-        safe_strncpy(pair.dst_ip, dst_ip->valuestring, sizeof(pair.dst_ip));
+    packet_decoder_init(&url->decoder, queue_pair, scanner);
+
+    if (curl_multi_add_handle(scanner->curl_multi, url->easy) != CURLM_OK) {
+        status_add(scanner, STATUS_ERRORS, 1);
+        return -1;
     }
+    url->in_flight = 1;
+    scanner->in_flight++;
+    return 0;
+}
+
+// Starts every URL whose tick has come, one wheel slot per elapsed tick
+static void expire_timers(mac_scanner_t* scanner) {
+    timer_wheel_t* wheel = &scanner->wheel;
+    uint64_t now = wheel_now(wheel);
+
+    for (; wheel->tick <= now; wheel->tick++) {
+        int32_t* link = &wheel->slots[wheel->tick & (WHEEL_SLOTS - 1)];
+        int32_t deferred = -1;
+
+        while (*link >= 0) {
+            size_t index = (size_t)*link;
+            url_state_t* url = &scanner->urls[index];
+            if (url->due_tick > wheel->tick) {
+                // Due on a later lap
+                link = &url->wheel_next;
+                continue;
+            }
+            *link = url->wheel_next;
+
+            if (scanner->in_flight >= MAX_CONCURRENT_TRANSFERS) {
+                // Transfer cap reached: retry on the next tick
+                url->due_tick = wheel->tick + 1;
+                url->wheel_next = deferred;
+                deferred = (int32_t)index;
+            } else if (start_transfer(scanner, index) != 0) {
+                wheel_schedule(scanner, index, (uint64_t)scanner->poll_interval_ms);
+            }
+        }
 
-    // Add to ring buffer
-    if (push_ring_buffer(&scanner->ring_buffer, &pair, scanner) != 0) {
-        log_message(LOG_LEVEL_DEBUG, "Failed to push packet to ring buffer (possibly full)");
+        // Deferred URLs join the next slot, which this loop may still reach in the same call
+        while (deferred >= 0) {
+            url_state_t* url = &scanner->urls[deferred];
+            int32_t next = url->wheel_next;
+            int32_t* head = &wheel->slots[(wheel->tick + 1) & (WHEEL_SLOTS - 1)];
+            url->wheel_next = *head;
+            *head = deferred;
+            deferred = next;
+        }
     }
 }
 
-// Thread cleanup handler
-static void cleanup_thread_resources(void* arg) {
-    thread_context_t* ctx = (thread_context_t*)arg;
-    if (!ctx) return;
+// Packets were already queued as they decoded; this only accounts for what could not be used
+static void finish_response(mac_scanner_t* scanner, size_t index) {
+    packet_decoder_t* decoder = &scanner->urls[index].decoder;
 
-    log_message(LOG_LEVEL_DEBUG, "Thread %zu cleanup for URL %s",
-               ctx->index, ctx->url ? ctx->url : "unknown");
+    if (packet_decoder_finish(decoder) != 0) {
+        log_message(LOG_LEVEL_WARN, "JSON parse failed for %s after %zu bytes (%zu packets decoded)",
+                   scanner->api_urls[index], decoder->consumed, decoder->packets);
+        status_add(scanner, STATUS_ERRORS, 1);
+    }
+    if (decoder->invalid > 0) {
+        status_add(scanner, STATUS_ERRORS, decoder->invalid);
+    }
+}
 
-    atomic_store(&ctx->active, 0);
-    if (ctx->scanner) {
-        atomic_fetch_sub(&ctx->scanner->active_thread_count, 1);
+// Records the outcome of one poll and schedules the next, with exponential backoff after repeated failures
+static void complete_transfer(mac_scanner_t* scanner, CURL* easy, CURLcode res) {
+    void* priv = NULL;
+    curl_easy_getinfo(easy, CURLINFO_PRIVATE, &priv);
+    size_t index = (size_t)(uintptr_t)priv;
+    url_state_t* url = &scanner->urls[index];
+    const char* url_str = scanner->api_urls[index];
+
+    curl_multi_remove_handle(scanner->curl_multi, easy);
+    url->in_flight = 0;
+    scanner->in_flight--;
+
+    uint64_t delay_ms = (uint64_t)scanner->poll_interval_ms;
+    if (res == CURLE_OK) {
+        url->backoff_ms = INITIAL_BACKOFF_MS;
+        url->consecutive_errors = 0;
+        url->last_success_s = monotonic_ns() / 1000000000ULL;
+        finish_response(scanner, index);
+    } else {
+        log_message(LOG_LEVEL_WARN, "Request failed for %s: %s", url_str, curl_easy_strerror(res));
+        status_add(scanner, STATUS_REQUESTS_FAILED, 1);
+        url->consecutive_errors++;
+
+        if (url->consecutive_errors > 3) {
+            uint32_t max_backoff_ms = (uint32_t)scanner->poll_interval_ms * 10;
+            url->backoff_ms = url->backoff_ms * 2 > max_backoff_ms ? max_backoff_ms : url->backoff_ms * 2;
+            delay_ms = url->backoff_ms;
+            log_message(LOG_LEVEL_INFO, "Backing off for %u ms on URL %s after %u errors",
+                       url->backoff_ms, url_str, url->consecutive_errors);
+
+            // A handle failing for this long gets replaced, dropping any stuck connection state
+            if (url->consecutive_errors > 10 && monotonic_ns() / 1000000000ULL - url->last_success_s > 300) {
+                log_message(LOG_LEVEL_WARN, "URL %s has had too many errors, recreating its handle", url_str);
+                curl_easy_cleanup(url->easy);
+                url->easy = NULL;
+            }
+        }
     }
 
-    SAFE_FREE(ctx->url);
-    SAFE_FREE(ctx);
+    wheel_schedule(scanner, index, delay_ms);
 }
 
-// Thread watchdog to restart failed threads
-static void* thread_watchdog(void* arg) {
+// Event loop: expires the timer wheel, drives every transfer through the multi handle and sleeps in curl_multi_poll
+static void* poll_loop(void* arg) {
     mac_scanner_t* scanner = (mac_scanner_t*)arg;
-    if (!scanner) return NULL;
+    scanner->batch = secure_malloc(sizeof(packet_batch_t));
+    if (!scanner->batch) {
+        log_message(LOG_LEVEL_ERROR, "Packet batch allocation failed");
+        return NULL;
+    }
+
+    log_message(LOG_LEVEL_INFO, "Event loop polling %zu URLs", scanner->url_count);
 
     while (atomic_load(&scanner->active) && atomic_load(&running)) {
-        sleep(30); // Check every 30 seconds
+        expire_timers(scanner);
 
-        pthread_mutex_lock(&scanner->mutex);
-        for (size_t i = 0; i < scanner->url_count; i++) {
-            // Create new thread if needed for each URL
-            if (scanner->polling_threads[i] == 0 ||
-                pthread_kill(scanner->polling_threads[i], 0) != 0) {
-
-                thread_context_t* ctx = secure_malloc(sizeof(*ctx));
-                if (!ctx) {
-                    log_message(LOG_LEVEL_ERROR, "Thread context allocation failed in watchdog");
-                    continue;
-                }
-
-                ctx->scanner = scanner;
-                ctx->index = i;
-                ctx->retries = 0;
-                ctx->url = secure_strdup(scanner->api_urls[i]);
-                atomic_store(&ctx->active, 0);
-
-                log_message(LOG_LEVEL_INFO, "Watchdog restarting thread for URL %s", ctx->url);
-
-                int ret = pthread_create(&scanner->polling_threads[i], NULL, poll_api_thread, ctx);
-                if (ret != 0) {
-                    log_message(LOG_LEVEL_ERROR, "Thread recreation failed: %s", strerror(ret));
-                    SAFE_FREE(ctx->url);
-                    SAFE_FREE(ctx);
-                    scanner->status.error_count++;
-                } else {
-                    atomic_fetch_add(&scanner->active_thread_count, 1);
-                }
+        int running_handles = 0;
+        curl_multi_perform(scanner->curl_multi, &running_handles);
+
+        CURLMsg* msg;
+        int queued;
+        while ((msg = curl_multi_info_read(scanner->curl_multi, &queued))) {
+            if (msg->msg == CURLMSG_DONE) {
+                complete_transfer(scanner, msg->easy_handle, msg->data.result);
             }
         }
-        pthread_mutex_unlock(&scanner->mutex);
+        flush_packet_batch(scanner->batch, scanner);
+        flush_flows(scanner, 0);
+
+        // Sleep until socket activity, curl's own timeout or the next wheel tick, whichever is first
+        long timeout_ms = WHEEL_TICK_MS;
+        long curl_timeout = -1;
+        curl_multi_timeout(scanner->curl_multi, &curl_timeout);
+        if (curl_timeout >= 0 && curl_timeout < timeout_ms) timeout_ms = curl_timeout;
+        curl_multi_poll(scanner->curl_multi, NULL, 0, (int)timeout_ms, NULL);
+    }
+
+    // Abandon transfers still running; their URLs are rescheduled from scratch on the next start
+    for (size_t i = 0; i < scanner->url_count; i++) {
+        url_state_t* url = &scanner->urls[i];
+        if (url->in_flight) {
+            curl_multi_remove_handle(scanner->curl_multi, url->easy);
+            url->in_flight = 0;
+        }
     }
+    scanner->in_flight = 0;
 
+    flush_packet_batch(scanner->batch, scanner);
+    flush_flows(scanner, 1);
+    SAFE_FREE(scanner->batch);
+    log_message(LOG_LEVEL_INFO, "Event loop exiting");
     return NULL;
 }
 
+// Start polling every URL from one event loop thread; first polls are spread over one interval
+EXPORT int mac_scanner_start(mac_scanner_t* scanner) {
+    if (!scanner) return -1;
+
+    int expected = 0;
+    if (!atomic_compare_exchange_strong(&scanner->loop_started, &expected, 1)) {
+        return 0; // already running
+    }
+
+    wheel_init(&scanner->wheel);
+    scanner->next_flow_flush_ns = monotonic_ns() + scanner->flow_flush_interval_ns;
+    for (size_t i = 0; i < scanner->url_count; i++) {
+        scanner->urls[i].backoff_ms = INITIAL_BACKOFF_MS;
+        scanner->urls[i].consecutive_errors = 0;
+        wheel_schedule(scanner, i, (uint64_t)scanner->poll_interval_ms * i / scanner->url_count);
+    }
+
+    atomic_store(&scanner->active, 1);
+    atomic_store(&scanner->shutdown_requested, 0);
+    int ret = pthread_create(&scanner->loop_thread, NULL, poll_loop, scanner);
+    if (ret != 0) {
+        log_message(LOG_LEVEL_ERROR, "Event loop thread creation failed: %s", strerror(ret));
+        atomic_store(&scanner->active, 0);
+        atomic_store(&scanner->loop_started, 0);
+        return -1;
+    }
+    return 0;
+}
+
+// Stop polling and wait for the event loop to exit; pairs already in the ring stay poppable
+EXPORT void mac_scanner_stop(mac_scanner_t* scanner) {
+    if (!scanner) return;
+
+    atomic_store(&scanner->active, 0);
+    atomic_store(&scanner->shutdown_requested, 1);
+    if (!atomic_load(&scanner->loop_started)) return;
+
+    curl_multi_wakeup(scanner->curl_multi);
+    pthread_join(scanner->loop_thread, NULL);
+    atomic_store(&scanner->loop_started, 0);
+}
+
+// Flow table plus the batch and queue its flows pass through; the queue holds two full flushes
+static int init_flow_aggregation(mac_scanner_t* scanner, size_t table_size, int flush_interval_ms) {
+    scanner->flow_table = flow_table_create(table_size, queue_flow, scanner);
+    scanner->flow_batch = secure_malloc(sizeof(flow_batch_t));
+    scanner->flow_queue.capacity = table_size * 2;
+    scanner->flow_queue.flows = secure_malloc(scanner->flow_queue.capacity * sizeof(mac_flow_t));
+    if (!scanner->flow_table || !scanner->flow_batch || !scanner->flow_queue.flows) {
+        return -1;
+    }
+
+    int interval_ms = flush_interval_ms > 0 ? flush_interval_ms : DEFAULT_FLOW_FLUSH_MS;
+    if (interval_ms < WHEEL_TICK_MS) interval_ms = WHEEL_TICK_MS;
+    scanner->flow_flush_interval_ns = (uint64_t)interval_ms * 1000000ULL;
+    log_message(LOG_LEVEL_INFO, "Aggregating pairs into up to %zu flows, flushed every %d ms", table_size, interval_ms);
+    return 0;
+}
+
 // Version API
 EXPORT const char* mac_scanner_version(void) {
     return MAC_SCANNER_VERSION;
@@ -670,6 +1003,12 @@ EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char*
         return NULL;
     }
 
+    if (config->flow_table_size > MAX_FLOW_TABLE_SIZE ||
+        (config->flow_table_size & (config->flow_table_size - 1)) != 0) {
+        safe_strncpy(err_buf, "Flow table size must be a power of two up to 2^24, or 0", err_buf_size);
+        return NULL;
+    }
+
     // Validate CA certificate if provided
     if (config->ca_cert_path) {
         struct stat st;
@@ -683,17 +1022,22 @@ EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char*
     // Initialize curl
     curl_global_init(CURL_GLOBAL_ALL);
 
-    // Allocate scanner
-    mac_scanner_t* scanner = secure_malloc(sizeof(mac_scanner_t));
+    // Allocate scanner; aligned because the ring cursors are padded to cache lines
+    mac_scanner_t* scanner = aligned_alloc(alignof(mac_scanner_t), sizeof(mac_scanner_t));
     if (!scanner) {
         safe_strncpy(err_buf, "Memory allocation failed for scanner", err_buf_size);
         curl_global_cleanup();
         return NULL;
     }
+    memset(scanner, 0, sizeof(mac_scanner_t));
 
-    // Initialize mutexes
+    // Initialize mutexes; flow waits use the monotonic clock like everything else here
     pthread_mutex_init(&scanner->mutex, NULL);
-    pthread_rwlock_init(&scanner->status_lock, NULL);
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&scanner->flow_queue.ready, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
 
     // Copy configuration data
     scanner->url_count = config->url_count;
@@ -733,17 +1077,17 @@ EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char*
         }
     }
 
-    // Initialize thread tracking
-    scanner->polling_threads = secure_malloc(config->url_count * sizeof(pthread_t));
-    if (!scanner->polling_threads) {
-        safe_strncpy(err_buf, "Memory allocation failed for thread array", err_buf_size);
+    // Initialize per-URL poll state
+    scanner->urls = secure_malloc(config->url_count * sizeof(url_state_t));
+    if (!scanner->urls) {
+        safe_strncpy(err_buf, "Memory allocation failed for URL state", err_buf_size);
         mac_scanner_free(scanner);
         return NULL;
     }
 
-    // Initialize ring buffer
-    size_t buffer_size = config->ring_buffer_size / sizeof(mac_pair_t);
-    if (buffer_size < 64) buffer_size = 64; // Minimum buffer size
+    // Initialize ring buffer: as many slots as fit the configured bytes, rounded down to a power of two
+    size_t buffer_size = 64; // Minimum buffer size
+    while (buffer_size * 2 * sizeof(ring_slot_t) <= config->ring_buffer_size) buffer_size *= 2;
 
     if (init_ring_buffer(&scanner->ring_buffer, buffer_size) < 0) {
         safe_strncpy(err_buf, "Ring buffer initialization failed", err_buf_size);
@@ -751,6 +1095,14 @@ EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char*
         return NULL;
     }
 
+    // Optional flow aggregation in front of the ring
+    if (config->flow_table_size > 0 &&
+        init_flow_aggregation(scanner, config->flow_table_size, config->flow_flush_interval_ms) < 0) {
+        safe_strncpy(err_buf, "Flow table initialization failed", err_buf_size);
+        mac_scanner_free(scanner);
+        return NULL;
+    }
+
     // Initialize curl multi-handle
     scanner->curl_multi = curl_multi_init();
     if (!scanner->curl_multi) {
@@ -758,6 +1110,7 @@ EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char*
         mac_scanner_free(scanner);
         return NULL;
     }
+    curl_multi_setopt(scanner->curl_multi, CURLMOPT_MAXCONNECTS, (long)MAX_CONCURRENT_TRANSFERS);
 
     // Drop privileges if requested
     if (config->drop_privileges && config->username) {
@@ -770,140 +1123,134 @@ EXPORT mac_scanner_t* mac_scanner_init(const mac_scanner_config_t* config, char*
     // Initialize state
     atomic_store(&scanner->active, 0);
     atomic_store(&scanner->shutdown_requested, 0);
-    atomic_store(&scanner->active_thread_count, 0);
     atomic_store(&scanner->last_error_time, 0);
+    atomic_store(&scanner->loop_started, 0);
 
     log_message(LOG_LEVEL_INFO, "Scanner initialized for %zu URLs", config->url_count);
     return scanner;
 }
-static void* poll_api_thread(void* arg) {
-    thread_context_t* ctx = (thread_context_t*)arg;
-    if (!ctx || !ctx->scanner || !ctx->url) {
-        log_message(LOG_LEVEL_ERROR, "Invalid thread context");
-        return NULL;
-    }
 
-    // Setup thread cleanup handler
-    pthread_cleanup_push(cleanup_thread_resources, ctx);
+// Release scanner, stopping the event loop if it is still running
+EXPORT void mac_scanner_free(mac_scanner_t* scanner) {
+    if (!scanner) return;
 
-    // Thread initialization
-    atomic_store(&ctx->active, 1);
-    mac_scanner_t* scanner = ctx->scanner;
-    const char* url = ctx->url;
-    CURL* curl = curl_easy_init();
-    response_t response = {0};
-    struct timespec ts;
-    int consecutive_errors = 0;
-    uint64_t last_success_time = 0;
+    mac_scanner_stop(scanner);
+    if (scanner->ring_buffer.slots) {
+        shutdown_ring_buffer(&scanner->ring_buffer);
+    }
+    pthread_mutex_lock(&scanner->mutex);
+    scanner->flow_queue.closed = 1;
+    pthread_cond_broadcast(&scanner->flow_queue.ready);
+    pthread_mutex_unlock(&scanner->mutex);
+
+    if (scanner->urls) {
+        for (size_t i = 0; i < scanner->url_count; i++) {
+            if (scanner->urls[i].easy) {
+                curl_easy_cleanup(scanner->urls[i].easy);
+            }
+        }
+    }
+    if (scanner->curl_multi) {
+        curl_multi_cleanup(scanner->curl_multi);
+    }
+    destroy_ring_buffer(&scanner->ring_buffer);
 
-    log_message(LOG_LEVEL_INFO, "Started polling thread %zu for URL: %s", ctx->index, url);
+    if (scanner->api_urls) {
+        for (size_t i = 0; i < scanner->url_count; i++) {
+            SAFE_FREE(scanner->api_urls[i]);
+        }
+    }
+    SAFE_FREE(scanner->api_urls);
+    SAFE_FREE(scanner->urls);
+    SAFE_FREE(scanner->ca_cert_path);
+    SAFE_FREE(scanner->version);
+    flow_table_free(scanner->flow_table);
+    SAFE_FREE(scanner->flow_batch);
+    SAFE_FREE(scanner->flow_queue.flows);
+
+    pthread_cond_destroy(&scanner->flow_queue.ready);
+    pthread_mutex_destroy(&scanner->mutex);
+    free(scanner);
+    curl_global_cleanup();
+}
 
-    if (!curl) {
-        log_message(LOG_LEVEL_ERROR, "CURL init failed for %s", url);
-        pthread_rwlock_wrlock(&scanner->status_lock);
-        scanner->status.error_count++;
-        pthread_rwlock_unlock(&scanner->status_lock);
-        pthread_exit(NULL);
+// Consumer side of the ring buffer
+EXPORT int mac_scanner_pop(mac_scanner_t* scanner, mac_pair_t* pair, int timeout_ms) {
+    if (!scanner || !pair) {
+        return -1;
     }
+    return pop_ring_buffer_batch(&scanner->ring_buffer, pair, 1, timeout_ms) == 1 ? 0 : -1;
+}
 
-    // Exponential backoff parameters
-    int backoff_ms = 100;
-    int max_backoff_ms = scanner->poll_interval_ms * 10;
+// Sums the shards; each shard is read under its seqlock, so it never blocks a writer
+EXPORT int mac_scanner_get_status(mac_scanner_t* scanner, mac_scanner_status_t* status) {
+    if (!scanner || !status) {
+        return -1;
+    }
 
-    // Main polling loop
-    while (atomic_load(&scanner->active) && atomic_load(&running)) {
-        // Initialize response buffer
-        response.data = NULL;
-        response.size = 0;
-        response.capacity = 0;
-
-        // Configure and perform request
-        configure_curl_handle(curl, url, &response, scanner->ca_cert_path, scanner->poll_interval_ms);
-        CURLcode res = curl_easy_perform(curl);
-
-        // Check for success
-        if (res == CURLE_OK) {
-            // Reset backoff on success
-            backoff_ms = 100;
-            consecutive_errors = 0;
-            clock_gettime(CLOCK_MONOTONIC, &ts);
-            last_success_time = ts.tv_sec;
-
-            // Process response if we have valid JSON
-            if (response.data && response.size > 0) {
-                cJSON* json = cJSON_Parse(response.data);
-                if (json) {
-                    // Handle both array and object responses
-                    if (cJSON_IsArray(json)) {
-                        cJSON* packet = NULL;
-                        cJSON_ArrayForEach(packet, json) {
-                            process_json_packet(packet, scanner);
-                        }
-                    } else if (cJSON_IsObject(json)) {
-                        // Some APIs might return a single object
-                        process_json_packet(json, scanner);
-                    }
-
-                    cJSON_Delete(json);
-                } else {
-                    log_message(LOG_LEVEL_WARN, "JSON parse failed for %s: %s",
-                              url, cJSON_GetErrorPtr() ? cJSON_GetErrorPtr() : "Unknown error");
-                    pthread_rwlock_wrlock(&scanner->status_lock);
-                    scanner->status.error_count++;
-                    pthread_rwlock_unlock(&scanner->status_lock);
-                }
-            }
-        } else {
-            // Handle error with exponential backoff
-            log_message(LOG_LEVEL_WARN, "Request failed for %s: %s", url, curl_easy_strerror(res));
-            pthread_rwlock_wrlock(&scanner->status_lock);
-            scanner->status.requests_failed++;
-            pthread_rwlock_unlock(&scanner->status_lock);
-
-            consecutive_errors++;
-
-            // Implement exponential backoff
-            if (consecutive_errors > 3) {
-                backoff_ms *= 2;
-                if (backoff_ms > max_backoff_ms) {
-                    backoff_ms = max_backoff_ms;
-                }
-
-                log_message(LOG_LEVEL_INFO, "Backing off for %d ms on URL %s after %d errors",
-                          backoff_ms, url, consecutive_errors);
-
-                // Sleep with backoff but check for termination
-                for (int i = 0; i < backoff_ms / 100 && atomic_load(&scanner->active) && atomic_load(&running); i++) {
-                    usleep(100 * 1000);
-                }
-
-                // Check for thread restart if errors persist
-                clock_gettime(CLOCK_MONOTONIC, &ts);
-                if (consecutive_errors > 10 && ts.tv_sec - last_success_time > 300) {
-                    log_message(LOG_LEVEL_WARN, "Thread %zu for URL %s has had too many errors, restarting",
-                              ctx->index, url);
-                    break;
-                }
-
-                // Clean up and continue
-                SAFE_FREE(response.data);
-                continue;
+    uint64_t totals[STATUS_COUNTER_COUNT] = {0};
+    for (size_t i = 0; i < STATUS_SHARDS; i++) {
+        status_shard_t* shard = &scanner->status_shards[i];
+        uint64_t values[STATUS_COUNTER_COUNT];
+        uint32_t before, after;
+        do {
+            before = atomic_load_explicit(&shard->seq, memory_order_acquire);
+            for (int c = 0; c < STATUS_COUNTER_COUNT; c++) {
+                values[c] = atomic_load_explicit(&shard->counters[c], memory_order_relaxed);
             }
+            atomic_thread_fence(memory_order_acquire);
+            after = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        for (int c = 0; c < STATUS_COUNTER_COUNT; c++) {
+            totals[c] += values[c];
         }
+    }
 
-        SAFE_FREE(response.data);
+    status->packets_processed = totals[STATUS_PACKETS_PROCESSED];
+    status->buffer_full_count = totals[STATUS_BUFFER_FULL];
+    status->requests_failed = totals[STATUS_REQUESTS_FAILED];
+    status->error_count = totals[STATUS_ERRORS];
+    status->flows_emitted = totals[STATUS_FLOWS_EMITTED];
+    status->buffer_fill = scanner->ring_buffer.slots ? ring_buffer_fill(&scanner->ring_buffer) : 0;
+    return 0;
+}
 
-        // Sleep for poll interval with interruption support
-        for (int i = 0; i < scanner->poll_interval_ms / 100 && atomic_load(&scanner->active) && atomic_load(&running); i++) {
-            usleep(100 * 1000);
-        }
+EXPORT size_t mac_scanner_pop_batch(mac_scanner_t* scanner, mac_pair_t* pairs, size_t max, int timeout_ms) {
+    if (!scanner || !pairs) {
+        return 0;
+    }
+    return pop_ring_buffer_batch(&scanner->ring_buffer, pairs, max, timeout_ms);
+}
+
+// Consumer side of the flow queue; waits on the monotonic clock until the deadline or a flush
+EXPORT size_t mac_scanner_pop_flows(mac_scanner_t* scanner, mac_flow_t* flows, size_t max, int timeout_ms) {
+    if (!scanner || !flows || max == 0 || !scanner->flow_table) {
+        return 0;
     }
 
-    // Cleanup
-    curl_easy_cleanup(curl);
-    SAFE_FREE(response.data);
-    log_message(LOG_LEVEL_INFO, "Polling thread %zu for URL %s exiting", ctx->index, url);
+    flow_queue_t* queue = &scanner->flow_queue;
+    pthread_mutex_lock(&scanner->mutex);
+    if (queue->count == 0 && timeout_ms > 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (queue->count == 0 && !queue->closed) {
+            if (pthread_cond_timedwait(&queue->ready, &scanner->mutex, &deadline) == ETIMEDOUT) break;
+        }
+    }
 
-    pthread_cleanup_pop(1); // Execute cleanup handler
-    return NULL;
+    size_t n = queue->count < max ? queue->count : max;
+    for (size_t i = 0; i < n; i++) {
+        flows[i] = queue->flows[(queue->head + i) & (queue->capacity - 1)];
+    }
+    queue->head = (queue->head + n) & (queue->capacity - 1);
+    queue->count -= n;
+    pthread_mutex_unlock(&scanner->mutex);
+    return n;
 }
@@ -0,0 +1,429 @@
+#include "../include/packet_decoder.h"
+#include "../include/addr_parse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+enum {
+    PD_VALUE,            // expecting any value
+    PD_VALUE_OR_END,     // just after '[': a value or ']'
+    PD_KEY_OR_END,       // just after '{': a key or '}'
+    PD_KEY,              // after ',' in an object
+    PD_COLON,
+    PD_AFTER_VALUE,      // expecting ',' or the closing bracket
+    PD_STRING,
+    PD_STRING_ESCAPE,
+    PD_STRING_UNICODE,
+    PD_NUMBER,
+    PD_LITERAL,
+    PD_DONE,             // top-level value complete, only whitespace may follow
+    PD_ERROR
+};
+
+enum {
+    PD_FIELD_NONE,
+    PD_FIELD_SRC_MAC,
+    PD_FIELD_DST_MAC,
+    PD_FIELD_SRC_IP,
+    PD_FIELD_DST_IP,
+    PD_FIELD_TIMESTAMP
+};
+
+// Positions in the JSON number grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+enum {
+    PN_SIGN,
+    PN_ZERO,
+    PN_INT,
+    PN_POINT,
+    PN_FRACTION,
+    PN_EXP,
+    PN_EXP_SIGN,
+    PN_EXP_DIGITS,
+    PN_INVALID
+};
+
+#define PD_SEEN(field) (1u << (field))
+
+void packet_decoder_init(packet_decoder_t* decoder, packet_sink_fn sink, void* ctx) {
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->state = PD_VALUE;
+    decoder->sink = sink;
+    decoder->ctx = ctx;
+}
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Key names compare case-insensitively, as cJSON_GetObjectItem did
+static int key_equals(const char* key, const char* name, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = key[i];
+        if (c >= 'A' && c <= 'Z') c |= 0x20;
+        if (c != name[i]) return 0;
+    }
+    return 1;
+}
+
+static int match_field(const char* key, size_t len) {
+    switch (len) {
+    case 6:
+        if (key_equals(key, "src_ip", 6)) return PD_FIELD_SRC_IP;
+        if (key_equals(key, "dst_ip", 6)) return PD_FIELD_DST_IP;
+        break;
+    case 7:
+        if (key_equals(key, "src_mac", 7)) return PD_FIELD_SRC_MAC;
+        if (key_equals(key, "dst_mac", 7)) return PD_FIELD_DST_MAC;
+        break;
+    case 9:
+        if (key_equals(key, "timestamp", 9)) return PD_FIELD_TIMESTAMP;
+        break;
+    }
+    return PD_FIELD_NONE;
+}
+
+static uint8_t number_step(uint8_t pos, char c) {
+    const int digit = c >= '0' && c <= '9';
+    const int exp = c == 'e' || c == 'E';
+    switch (pos) {
+    case PN_SIGN:
+        return c == '0' ? PN_ZERO : digit ? PN_INT : PN_INVALID;
+    case PN_ZERO:
+        return c == '.' ? PN_POINT : exp ? PN_EXP : PN_INVALID;
+    case PN_INT:
+        return digit ? PN_INT : c == '.' ? PN_POINT : exp ? PN_EXP : PN_INVALID;
+    case PN_POINT:
+        return digit ? PN_FRACTION : PN_INVALID;
+    case PN_FRACTION:
+        return digit ? PN_FRACTION : exp ? PN_EXP : PN_INVALID;
+    case PN_EXP:
+        return c == '+' || c == '-' ? PN_EXP_SIGN : digit ? PN_EXP_DIGITS : PN_INVALID;
+    case PN_EXP_SIGN:
+    case PN_EXP_DIGITS:
+        return digit ? PN_EXP_DIGITS : PN_INVALID;
+    default:
+        return PN_INVALID;
+    }
+}
+
+static int number_complete(uint8_t pos) {
+    return pos == PN_ZERO || pos == PN_INT || pos == PN_FRACTION || pos == PN_EXP_DIGITS;
+}
+
+// Keeps a byte of a value or key we care about; anything else is only scanned
+static void capture(packet_decoder_t* d, unsigned char c) {
+    if (d->len + 1 >= PACKET_DECODER_CAPTURE || c >= 0x80) {
+        d->overflow = 1;
+        return;
+    }
+    d->buf[d->len++] = (char)c;
+}
+
+static int capturing(const packet_decoder_t* d) {
+    return d->string_is_key ? d->depth == d->packet_depth : d->field != PD_FIELD_NONE;
+}
+
+static void begin_packet(packet_decoder_t* d) {
+    memset(&d->pair, 0, sizeof(d->pair));
+    d->seen = 0;
+}
+
+static void end_packet(packet_decoder_t* d) {
+    unsigned required = PD_SEEN(PD_FIELD_SRC_MAC) | PD_SEEN(PD_FIELD_DST_MAC);
+    if ((d->seen & required) != required) {
+        d->invalid++;
+        return;
+    }
+
+    // Prefer the provided timestamp, fall back to the current time
+    if (!(d->seen & PD_SEEN(PD_FIELD_TIMESTAMP))) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        d->pair.timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    }
+
+    d->packets++;
+    if (d->sink) d->sink(&d->pair, d->ctx);
+}
+
+// A recognized key's string value is complete; only a valid value marks the field as seen
+static void store_string(packet_decoder_t* d) {
+    if (d->overflow) return;
+
+    mac_addr_t mac;
+    uint8_t ip[16] = {0};
+    int family;
+    switch (d->field) {
+    case PD_FIELD_SRC_MAC:
+        if (parse_mac_n(d->buf, d->len, &mac) != 0) break;
+        d->pair.src_mac = mac;
+        d->seen |= PD_SEEN(PD_FIELD_SRC_MAC);
+        break;
+    case PD_FIELD_DST_MAC:
+        if (parse_mac_n(d->buf, d->len, &mac) != 0) break;
+        d->pair.dst_mac = mac;
+        d->seen |= PD_SEEN(PD_FIELD_DST_MAC);
+        break;
+    case PD_FIELD_SRC_IP:
+        if ((family = parse_ip(d->buf, d->len, ip)) < 0) break;
+        d->pair.src_family = (unsigned)family;
+        memcpy(d->pair.src_ip, ip, sizeof(ip));
+        break;
+    case PD_FIELD_DST_IP:
+        if ((family = parse_ip(d->buf, d->len, ip)) < 0) break;
+        d->pair.dst_family = (unsigned)family;
+        memcpy(d->pair.dst_ip, ip, sizeof(ip));
+        break;
+    }
+}
+
+static void store_number(packet_decoder_t* d) {
+    if (d->field != PD_FIELD_TIMESTAMP || d->overflow) return;
+    d->buf[d->len] = 0;
+
+    // The token already passed the number grammar; only its range is left to check
+    double seconds = strtod(d->buf, NULL);
+    if (!(seconds >= 0.0 && seconds < (double)UINT64_MAX / 1000000000.0)) return;
+    d->pair.timestamp_ns = (uint64_t)(seconds * 1000000000.0);
+    d->seen |= PD_SEEN(PD_FIELD_TIMESTAMP);
+}
+
+static void value_done(packet_decoder_t* d) {
+    d->field = PD_FIELD_NONE;
+    d->state = d->depth == 0 ? PD_DONE : PD_AFTER_VALUE;
+}
+
+static void start_token(packet_decoder_t* d) {
+    d->len = 0;
+    d->overflow = 0;
+}
+
+static int open_container(packet_decoder_t* d, int is_object) {
+    if (d->depth == 0 && d->packet_depth == 0) {
+        d->packet_depth = is_object ? 1 : 2;
+    }
+    if (d->depth + 1 >= PACKET_DECODER_MAX_DEPTH) return -1;
+
+    if (is_object) d->objects |= 1ULL << d->depth;
+    else d->objects &= ~(1ULL << d->depth);
+    d->depth++;
+
+    if (is_object && d->depth == d->packet_depth) begin_packet(d);
+    d->field = PD_FIELD_NONE;
+    d->state = is_object ? PD_KEY_OR_END : PD_VALUE_OR_END;
+    return 0;
+}
+
+static int close_container(packet_decoder_t* d, int is_object) {
+    if (d->depth == 0) return -1;
+    int top_is_object = (d->objects >> (d->depth - 1)) & 1;
+    if (top_is_object != is_object) return -1;
+
+    if (is_object && d->depth == d->packet_depth) end_packet(d);
+    d->depth--;
+    value_done(d);
+    return 0;
+}
+
+static int in_object(const packet_decoder_t* d) {
+    return d->depth > 0 && ((d->objects >> (d->depth - 1)) & 1);
+}
+
+// Starts whatever value begins with c; -1 if nothing can
+static int begin_value(packet_decoder_t* d, char c) {
+    // An array response holds packets; any element that is not an object is one that failed validation
+    if (c != '{' && d->packet_depth == 2 && d->depth == 1) d->invalid++;
+
+    switch (c) {
+    case '{':
+        return open_container(d, 1);
+    case '[':
+        return open_container(d, 0);
+    case '"':
+        start_token(d);
+        d->string_is_key = 0;
+        d->state = PD_STRING;
+        return 0;
+    case 't':
+    case 'f':
+    case 'n':
+        start_token(d);
+        d->buf[d->len++] = c;
+        d->state = PD_LITERAL;
+        return 0;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            start_token(d);
+            d->buf[d->len++] = c;
+            d->number = c == '-' ? PN_SIGN : c == '0' ? PN_ZERO : PN_INT;
+            d->state = PD_NUMBER;
+            return 0;
+        }
+        return -1;
+    }
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static void end_string(packet_decoder_t* d) {
+    if (d->string_is_key) {
+        d->field = d->depth == d->packet_depth && !d->overflow ? match_field(d->buf, d->len) : PD_FIELD_NONE;
+        d->state = PD_COLON;
+        return;
+    }
+    store_string(d);
+    value_done(d);
+}
+
+static int literal_complete(const packet_decoder_t* d) {
+    return (d->len == 4 && (memcmp(d->buf, "true", 4) == 0 || memcmp(d->buf, "null", 4) == 0)) ||
+           (d->len == 5 && memcmp(d->buf, "false", 5) == 0);
+}
+
+// One byte through the state machine; numbers and literals end on a byte that belongs to the next token,
+// so those return 1 to have it processed again
+static int step(packet_decoder_t* d, char c) {
+    switch (d->state) {
+    case PD_VALUE:
+        if (is_space(c)) return 0;
+        return begin_value(d, c) < 0 ? -1 : 0;
+
+    case PD_VALUE_OR_END:
+        if (is_space(c)) return 0;
+        if (c == ']') return close_container(d, 0);
+        return begin_value(d, c) < 0 ? -1 : 0;
+
+    case PD_KEY_OR_END:
+    case PD_KEY:
+        if (is_space(c)) return 0;
+        if (c == '}' && d->state == PD_KEY_OR_END) return close_container(d, 1);
+        if (c != '"') return -1;
+        start_token(d);
+        d->string_is_key = 1;
+        d->state = PD_STRING;
+        return 0;
+
+    case PD_COLON:
+        if (is_space(c)) return 0;
+        if (c != ':') return -1;
+        d->state = PD_VALUE;
+        return 0;
+
+    case PD_AFTER_VALUE:
+        if (is_space(c)) return 0;
+        if (c == ',') {
+            d->field = PD_FIELD_NONE;
+            d->state = in_object(d) ? PD_KEY : PD_VALUE;
+            return 0;
+        }
+        if (c == '}') return close_container(d, 1);
+        if (c == ']') return close_container(d, 0);
+        return -1;
+
+    case PD_STRING:
+        if (c == '"') {
+            end_string(d);
+        } else if (c == '\\') {
+            d->state = PD_STRING_ESCAPE;
+        } else if ((unsigned char)c < 0x20) {
+            return -1;
+        } else if (capturing(d)) {
+            capture(d, (unsigned char)c);
+        }
+        return 0;
+
+    case PD_STRING_ESCAPE: {
+        char out;
+        switch (c) {
+        case '"': out = '"'; break;
+        case '\\': out = '\\'; break;
+        case '/': out = '/'; break;
+        case 'b': out = '\b'; break;
+        case 'f': out = '\f'; break;
+        case 'n': out = '\n'; break;
+        case 'r': out = '\r'; break;
+        case 't': out = '\t'; break;
+        case 'u':
+            d->unicode = 0;
+            d->unicode_digits = 0;
+            d->state = PD_STRING_UNICODE;
+            return 0;
+        default:
+            return -1;
+        }
+        if (capturing(d)) capture(d, (unsigned char)out);
+        d->state = PD_STRING;
+        return 0;
+    }
+
+    case PD_STRING_UNICODE: {
+        int v = hex_value(c);
+        if (v < 0) return -1;
+        d->unicode = (uint16_t)(d->unicode << 4 | v);
+        if (++d->unicode_digits < 4) return 0;
+        // Keys and values we decode are ASCII; anything wider spoils the capture
+        if (capturing(d)) capture(d, d->unicode < 0x80 ? (unsigned char)d->unicode : 0x80);
+        d->state = PD_STRING;
+        return 0;
+    }
+
+    case PD_NUMBER:
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            if ((d->number = number_step(d->number, c)) == PN_INVALID) return -1;
+            capture(d, (unsigned char)c);
+            return 0;
+        }
+        if (!number_complete(d->number)) return -1;
+        store_number(d);
+        value_done(d);
+        return 1;
+
+    case PD_LITERAL:
+        if (c >= 'a' && c <= 'z') {
+            capture(d, (unsigned char)c);
+            return 0;
+        }
+        if (!literal_complete(d)) return -1;
+        value_done(d);
+        return 1;
+
+    case PD_DONE:
+        return is_space(c) ? 0 : -1;
+
+    default:
+        return -1;
+    }
+}
+
+int packet_decoder_feed(packet_decoder_t* d, const char* data, size_t len) {
+    if (d->state == PD_ERROR) return -1;
+
+    for (size_t i = 0; i < len; i++) {
+        int rc;
+        // A number or literal ending here hands the byte on to the state that follows it
+        while ((rc = step(d, data[i])) == 1) {}
+        if (rc < 0) {
+            d->state = PD_ERROR;
+            d->consumed += i;
+            return -1;
+        }
+    }
+    d->consumed += len;
+    return 0;
+}
+
+int packet_decoder_finish(const packet_decoder_t* d) {
+    if (d->state == PD_DONE) return 0;
+    if (d->consumed == 0) return 0;
+    // A bare top-level number or literal ends with the input
+    if (d->depth == 0 && d->state == PD_NUMBER && number_complete(d->number)) return 0;
+    if (d->depth == 0 && d->state == PD_LITERAL && literal_complete(d)) return 0;
+    return -1;
+}
@@ -0,0 +1,69 @@
+// Microbenchmark for the case-insensitive search kernels over header- and body-sized inputs.
+// Build with -DSERVER_BUILD_BENCHMARKS=ON and run ./bench_casefind
+#include "../include/scanner/simd_search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define TARGET_BYTES (256UL * 1024 * 1024)
+
+// The loop strcasestr_exists() used before the kernels existed, kept as the baseline
+static const char* casefind_legacy(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return haystack;
+    if (needle_len > haystack_len) return NULL;
+    for (size_t i = 0; i <= haystack_len - needle_len; i++) {
+        if (strncasecmp(&haystack[i], needle, needle_len) == 0) return haystack + i;
+    }
+    return NULL;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Header-like filler: mixed case directive text with plenty of near-misses for the needle's first byte
+static void fill(char* buf, size_t len) {
+    static const char text[] = "Default-Src 'self'; Script-Src 'nonce-r4nd0m' https://cdn.example.com; Camera=(), Microphone=(self); ";
+    for (size_t i = 0; i < len; i++) buf[i] = text[i % (sizeof(text) - 1)];
+    buf[len] = 0;
+}
+
+static void run(const char* label, CasefindFn fn, const char* hay, size_t hay_len, const char* needle) {
+    if (!fn) return;
+    size_t needle_len = strlen(needle);
+    size_t iterations = TARGET_BYTES / (hay_len + 1);
+    if (iterations < 16) iterations = 16;
+    volatile size_t sink = 0;
+
+    double start = now_ns();
+    for (size_t i = 0; i < iterations; i++) sink += (size_t)(fn(hay, hay_len, needle, needle_len) != NULL);
+    double elapsed = now_ns() - start;
+    (void)sink;
+
+    printf("  %-8s %10.1f ns/op %8.2f GB/s\n", label, elapsed / iterations, (double)hay_len * iterations / elapsed);
+}
+
+int main(void) {
+    static const size_t sizes[] = { 64, 512, 4096, 64 * 1024, 1024 * 1024 };
+    static const char* const needles[] = { "geolocation 'none'", "'unsafe-eval'" }; // both absent: full scan
+
+    printf("dispatch: %s\n", simd_casefind_impl_name());
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        char* hay = malloc(sizes[s] + 1);
+        if (!hay) return EXIT_FAILURE;
+        fill(hay, sizes[s]);
+        for (size_t n = 0; n < sizeof(needles) / sizeof(needles[0]); n++) {
+            printf("%zu bytes, needle \"%s\"\n", sizes[s], needles[n]);
+            run("legacy", casefind_legacy, hay, sizes[s], needles[n]);
+            run("scalar", simd_casefind_scalar, hay, sizes[s], needles[n]);
+            run("sse2", simd_casefind_sse2_fn, hay, sizes[s], needles[n]);
+            if (simd_casefind_avx2_supported()) run("avx2", simd_casefind_avx2_fn, hay, sizes[s], needles[n]);
+        }
+        free(hay);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,300 @@
+// Microbenchmark for the header parsing hot path over small, typical and pathological header blocks.
+// Build with -DSERVER_BUILD_BENCHMARKS=ON and run ./bench_header_parse
+// ./bench_header_parse --dump-corpus DIR writes every block to DIR, e.g. as seeds for fuzz_header_parse
+#include "../include/scanner/http_headers_analyzer.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TARGET_HEADERS (2UL * 1000 * 1000)
+
+// Counting allocator: glibc routes its own internal allocations (strdup included) through a replaced malloc
+static size_t alloc_calls;
+static int alloc_counting;
+
+#ifdef __GLIBC__
+#define BENCH_COUNTS_ALLOCS 1
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    if (alloc_counting) alloc_calls++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    if (alloc_counting) alloc_calls++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    if (alloc_counting) alloc_calls++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+#else
+#define BENCH_COUNTS_ALLOCS 0
+#endif
+
+typedef struct {
+    const char* name;
+    char* raw;
+    // Split copy of the block, filled once so the per-function runs measure only that function
+    char** names;
+    char** values;
+    int count;
+} CorpusBlock;
+
+static const char small_block[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html; charset=utf-8\r\n"
+    "Content-Length: 1256\r\n"
+    "Date: Mon, 19 Oct 2026 09:14:02 GMT\r\n"
+    "\r\n";
+
+static const char typical_block[] =
+    "HTTP/2 200\r\n"
+    "content-type: text/html; charset=utf-8\r\n"
+    "date: Mon, 19 Oct 2026 09:14:02 GMT\r\n"
+    "server: nginx\r\n"
+    "vary: Accept-Encoding, Cookie\r\n"
+    "cache-control: private, no-cache, no-store, must-revalidate, max-age=0\r\n"
+    "pragma: no-cache\r\n"
+    "expires: Thu, 01 Jan 1970 00:00:00 GMT\r\n"
+    "strict-transport-security: max-age=63072000; includeSubDomains; preload\r\n"
+    "x-frame-options: SAMEORIGIN\r\n"
+    "x-content-type-options: nosniff\r\n"
+    "referrer-policy: strict-origin-when-cross-origin\r\n"
+    "permissions-policy: camera=(), microphone=(), geolocation=(self \"https://maps.example.com\"), interest-cohort=()\r\n"
+    "content-security-policy: default-src 'self'; script-src 'self' 'nonce-r4nd0mN0nc3' https://cdn.example.com "
+    "https://www.googletagmanager.com; style-src 'self' 'unsafe-inline' https://fonts.googleapis.com; img-src 'self' data: "
+    "https:; font-src 'self' https://fonts.gstatic.com; connect-src 'self' https://api.example.com wss://ws.example.com; "
+    "frame-ancestors 'none'; base-uri 'self'; form-action 'self'; upgrade-insecure-requests; report-uri /csp-report\r\n"
+    "cross-origin-opener-policy: same-origin\r\n"
+    "cross-origin-resource-policy: same-site\r\n"
+    "set-cookie: __Host-session=3f9a1c0e7b2d4a6f8e5c1b0a9d8e7f6a; Path=/; Secure; HttpOnly; SameSite=Lax\r\n"
+    "set-cookie: csrftoken=Zm9vYmFyYmF6cXV4; Path=/; Max-Age=31449600; Secure; SameSite=Strict\r\n"
+    "set-cookie: _ga=GA1.2.1234567890.1760000000; Domain=.example.com; Path=/; Expires=Wed, 19 Oct 2027 09:14:02 GMT\r\n"
+    "etag: W/\"5e8c-1a2b3c4d5e6f\"\r\n"
+    "last-modified: Sun, 18 Oct 2026 22:01:44 GMT\r\n"
+    "alt-svc: h3=\":443\"; ma=86400, h3-29=\":443\"; ma=86400\r\n"
+    "report-to: {\"group\":\"default\",\"max_age\":31536000,\"endpoints\":[{\"url\":\"https://report.example.com/a\"}]}\r\n"
+    "nel: {\"report_to\":\"default\",\"max_age\":31536000,\"include_subdomains\":true}\r\n"
+    "x-request-id: 7c3e1f0a-9b8d-4c2e-a1f0-3d5b7e9c1a2b\r\n"
+    "x-cache: Hit from cloudfront\r\n"
+    "via: 1.1 6f2a1b3c4d5e.cloudfront.net (CloudFront)\r\n"
+    "\r\n";
+
+typedef struct {
+    char* buf;
+    size_t len;
+    size_t cap;
+} Builder;
+
+static void append(Builder* b, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void append(Builder* b, const char* fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(b->buf + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if (b->len + (size_t)n < b->cap) { b->len += (size_t)n; return; }
+        b->cap = (b->cap + (size_t)n + 1) * 2;
+        char* ptr = realloc(b->buf, b->cap);
+        if (!ptr) exit(EXIT_FAILURE);
+        b->buf = ptr;
+    }
+}
+
+// Many copies of one header: each add appends to the same duplicate chain
+static char* make_duplicates(int count) {
+    Builder b = {0};
+    append(&b, "HTTP/1.1 200 OK\r\n");
+    for (int i = 0; i < count; i++) append(&b, "Set-Cookie: tracker_%d=%08x; Path=/; Max-Age=3600; Secure\r\n", i, (unsigned)i * 2654435761u);
+    append(&b, "\r\n");
+    return b.buf;
+}
+
+// Distinct unknown names: each lookup misses the perfect hash and goes to the collection's name table
+static char* make_unknown_names(void) {
+    Builder b = {0};
+    append(&b, "HTTP/1.1 200 OK\r\n");
+    for (int i = 0; i < 300; i++) append(&b, "X-Custom-Trace-%d: span=%d; sampled=1\r\n", i, i);
+    append(&b, "\r\n");
+    return b.buf;
+}
+
+// One CSP of about 60 KB
+static char* make_long_value(void) {
+    Builder b = {0};
+    append(&b, "HTTP/1.1 200 OK\r\nContent-Security-Policy: default-src 'self'");
+    for (int i = 0; b.len < 60 * 1024; i++) append(&b, "; script-src-elem 'self' https://cdn%d.example.com 'sha256-%032x'", i, (unsigned)i);
+    append(&b, "\r\n\r\n");
+    return b.buf;
+}
+
+// Padding around names and values, tabs, and bare LF mixed with CRLF
+static char* make_whitespace(void) {
+    Builder b = {0};
+    append(&b, "HTTP/1.1 200 OK\n");
+    for (int i = 0; i < 64; i++) {
+        append(&b, "Cache-Control:  \t   no-cache ;  max-age = %d  ;\t private   \t%s", i, i % 2 ? "\r\n" : "\n");
+        append(&b, "X-Padded-%d:%*s%s", i, 40, "", i % 3 ? "\r\n" : "\n");
+    }
+    append(&b, "\r\n");
+    return b.buf;
+}
+
+// Names longer than MAX_HEADER_NAME and values without any separator
+static char* make_long_names(void) {
+    Builder b = {0};
+    append(&b, "HTTP/1.1 200 OK\r\n");
+    for (int i = 0; i < 64; i++) append(&b, "X-%0200d: %0300d\r\n", i, i);
+    append(&b, "\r\n");
+    return b.buf;
+}
+
+static void corpus_split(CorpusBlock* block) {
+    HeaderCollection hc = {0};
+    parse_raw_headers(block->raw, &hc);
+    block->count = hc.count;
+    block->names = calloc((size_t)hc.count + 1, sizeof(char*));
+    block->values = calloc((size_t)hc.count + 1, sizeof(char*));
+    if (!block->names || !block->values) exit(EXIT_FAILURE);
+    for (int i = 0; i < hc.count; i++) {
+        block->names[i] = strdup(header_name_at(&hc, i));
+        block->values[i] = strdup(header_value_at(&hc, i));
+    }
+    header_collection_free(&hc);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+typedef void (*BenchFn)(const CorpusBlock* block, char* scratch);
+
+static void run_parse_raw_headers(const CorpusBlock* block, char* scratch) {
+    (void)scratch;
+    HeaderCollection hc = {0};
+    parse_raw_headers(block->raw, &hc);
+    header_collection_free(&hc);
+}
+
+static void run_add_header(const CorpusBlock* block, char* scratch) {
+    (void)scratch;
+    HeaderCollection hc = {0};
+    for (int i = 0; i < block->count; i++) add_header(&hc, block->names[i], block->values[i]);
+    header_collection_free(&hc);
+}
+
+static void run_normalize_name(const CorpusBlock* block, char* scratch) {
+    for (int i = 0; i < block->count; i++) normalize_name(scratch, block->names[i]);
+}
+
+// trim_whitespace edits in place, so each value is first copied back with padding; the copy is part of the cost
+static void run_trim_whitespace(const CorpusBlock* block, char* scratch) {
+    for (int i = 0; i < block->count; i++) {
+        size_t len = strlen(block->values[i]);
+        memcpy(scratch, " \t", 2);
+        memcpy(scratch + 2, block->values[i], len);
+        memcpy(scratch + 2 + len, " \t", 3);
+        char* str = scratch;
+        trim_whitespace(&str);
+    }
+}
+
+static void run_parse_directives(const CorpusBlock* block, char* scratch) {
+    (void)scratch;
+    static DirectiveList dl;
+    for (int i = 0; i < block->count; i++) parse_directives(block->values[i], &dl);
+}
+
+static void run(const char* label, BenchFn fn, const CorpusBlock* block, char* scratch) {
+    if (block->count == 0) return;
+    size_t iterations = TARGET_HEADERS / (size_t)block->count;
+    if (iterations < 16) iterations = 16;
+
+    // One counted pass; the timed loop runs without the counter
+    alloc_calls = 0;
+    alloc_counting = 1;
+    fn(block, scratch);
+    alloc_counting = 0;
+    size_t allocs = alloc_calls;
+
+    double start = now_ns();
+    for (size_t i = 0; i < iterations; i++) fn(block, scratch);
+    double elapsed = now_ns() - start;
+
+    if (BENCH_COUNTS_ALLOCS) printf("  %-18s %10.1f ns/header %8zu allocs/parse\n", label, elapsed / ((double)iterations * block->count), allocs);
+    else printf("  %-18s %10.1f ns/header %8s allocs/parse\n", label, elapsed / ((double)iterations * block->count), "n/a");
+}
+
+static int dump_corpus(const char* dir, const CorpusBlock* blocks, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s.txt", dir, blocks[i].name);
+        FILE* f = fopen(path, "wb");
+        if (!f) { perror(path); return EXIT_FAILURE; }
+        fwrite(blocks[i].raw, 1, strlen(blocks[i].raw), f);
+        fclose(f);
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv) {
+    if (header_registry_init() != 0) return EXIT_FAILURE;
+
+    CorpusBlock blocks[] = {
+        { .name = "small", .raw = strdup(small_block) },
+        { .name = "typical", .raw = strdup(typical_block) },
+        { .name = "duplicates", .raw = make_duplicates(400) },
+        { .name = "duplicates-10k", .raw = make_duplicates(10000) },
+        { .name = "unknown-names", .raw = make_unknown_names() },
+        { .name = "long-value", .raw = make_long_value() },
+        { .name = "whitespace", .raw = make_whitespace() },
+        { .name = "long-names", .raw = make_long_names() },
+    };
+    size_t block_count = sizeof(blocks) / sizeof(blocks[0]);
+    for (size_t i = 0; i < block_count; i++) {
+        if (!blocks[i].raw) return EXIT_FAILURE;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--dump-corpus") == 0) return dump_corpus(argv[2], blocks, block_count);
+
+    // Room for the longest value plus trim padding, and at least one name
+    char* scratch = malloc(HEADER_POOL_LIMIT + 8);
+    if (!scratch) return EXIT_FAILURE;
+
+    for (size_t i = 0; i < block_count; i++) {
+        CorpusBlock* block = &blocks[i];
+        corpus_split(block);
+        printf("%s: %d headers, %zu bytes\n", block->name, block->count, strlen(block->raw));
+        run("parse_raw_headers", run_parse_raw_headers, block, scratch);
+        run("add_header", run_add_header, block, scratch);
+        run("normalize_name", run_normalize_name, block, scratch);
+        run("trim_whitespace", run_trim_whitespace, block, scratch);
+        run("parse_directives", run_parse_directives, block, scratch);
+
+        for (int h = 0; h < block->count; h++) {
+            free(block->names[h]);
+            free(block->values[h]);
+        }
+        free(block->names);
+        free(block->values);
+        free(block->raw);
+    }
+    free(scratch);
+    return EXIT_SUCCESS;
+}
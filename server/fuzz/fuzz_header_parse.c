@@ -0,0 +1,123 @@
+// Fuzz harness for the header parsing entry points, checking the collection invariants after every input.
+// Build with -DSERVER_BUILD_FUZZERS=ON. Under clang this is a libFuzzer target:
+//   ./fuzz_header_parse CORPUS_DIR    (seed CORPUS_DIR with ./bench_header_parse --dump-corpus CORPUS_DIR)
+// Other compilers get a replay driver that runs each file given on the command line once.
+#include "../include/scanner/http_headers_analyzer.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_CHECK(cond) do { if (!(cond)) { fprintf(stderr, "invariant failed: %s (%s:%d)\n", #cond, __FILE__, __LINE__); abort(); } } while (0)
+
+static void check_collection(const HeaderCollection* hc) {
+    FUZZ_CHECK(hc->count >= 0 && hc->count <= hc->capacity);
+    FUZZ_CHECK(hc->pool_len <= hc->pool_cap && hc->pool_len <= HEADER_POOL_LIMIT);
+
+    for (int i = 0; i < hc->count; i++) {
+        const HttpHeader* hdr = &hc->headers[i];
+        const char* name = header_name_at(hc, i);
+        const char* value = header_value_at(hc, i);
+        FUZZ_CHECK(hdr->value_off + hdr->value_len < hc->pool_len);
+        FUZZ_CHECK(strlen(name) <= hdr->name_len && strlen(value) <= hdr->value_len);
+        for (uint32_t c = 0; c < hdr->name_len; c++) FUZZ_CHECK(!isupper((unsigned char)name[c]));
+        if (hdr->value_len) {
+            FUZZ_CHECK(!isspace((unsigned char)value[0]) && !isspace((unsigned char)value[hdr->value_len - 1]));
+        }
+
+        // Every duplicate is reachable from the first occurrence, and only from there
+        int first = find_header(hc, name);
+        FUZZ_CHECK(first >= 0 && first <= i);
+        FUZZ_CHECK(hdr->first == first + 1);
+        if (first != i) continue;
+        int seen = 0, last = i + 1;
+        for (int next = hdr->next; next; next = hc->headers[next - 1].next) {
+            FUZZ_CHECK(next - 1 > i && next <= hc->count);
+            FUZZ_CHECK(hc->headers[next - 1].hash == hdr->hash);
+            last = next;
+            seen++;
+        }
+        FUZZ_CHECK(seen == hdr->duplicates);
+        FUZZ_CHECK(last == hdr->last);
+        if (hdr->id != HDR_UNKNOWN) FUZZ_CHECK(find_header_id(hc, hdr->id) == i);
+    }
+}
+
+static void check_directives(const char* value) {
+    DirectiveList dl;
+    parse_directives(value, &dl);
+    FUZZ_CHECK(dl.count >= 0 && dl.count <= 64);
+    for (int d = 0; d < dl.count; d++) {
+        FUZZ_CHECK(strlen(dl.directives[d].key) < sizeof(dl.directives[d].key));
+        FUZZ_CHECK(strlen(dl.directives[d].value) < sizeof(dl.directives[d].value));
+    }
+}
+
+int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    (void)argc;
+    (void)argv;
+    if (header_registry_init() != 0) abort();
+    return 0;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    char* input = malloc(size + 1);
+    if (!input) return 0;
+    memcpy(input, data, size);
+    input[size] = 0;
+
+    HeaderCollection hc = {0};
+    parse_raw_headers(input, &hc);
+    check_collection(&hc);
+
+    char name[MAX_HEADER_NAME];
+    for (int i = 0; i < hc.count; i++) {
+        normalize_name(name, header_name_at(&hc, i));
+        FUZZ_CHECK(strlen(name) < MAX_HEADER_NAME);
+        check_directives(header_value_at(&hc, i));
+    }
+
+    // The raw input once more as a single name: value pair, bypassing the line splitter
+    normalize_name(name, input);
+    check_directives(input);
+    char* trimmed = input;
+    trim_whitespace(&trimmed);
+    size_t trimmed_len = strlen(trimmed);
+    FUZZ_CHECK(trimmed_len == 0 || (!isspace((unsigned char)trimmed[0]) && !isspace((unsigned char)trimmed[trimmed_len - 1])));
+
+    HeaderCollection single = {0};
+    char* colon = strchr(trimmed, ':');
+    if (colon) {
+        *colon = 0;
+        add_header(&single, trimmed, colon + 1);
+        add_header(&single, trimmed, colon + 1);
+        check_collection(&single);
+    }
+
+    header_collection_free(&single);
+    header_collection_free(&hc);
+    free(input);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+int main(int argc, char** argv) {
+    LLVMFuzzerInitialize(&argc, &argv);
+    for (int i = 1; i < argc; i++) {
+        FILE* f = fopen(argv[i], "rb");
+        if (!f) { perror(argv[i]); return EXIT_FAILURE; }
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        uint8_t* data = malloc(len > 0 ? (size_t)len : 1);
+        if (!data) { fclose(f); return EXIT_FAILURE; }
+        size_t got = fread(data, 1, len > 0 ? (size_t)len : 0, f);
+        fclose(f);
+        LLVMFuzzerTestOneInput(data, got);
+        free(data);
+        printf("%s: ok\n", argv[i]);
+    }
+    return EXIT_SUCCESS;
+}
+#endif
@@ -2,12 +2,45 @@
 #define GRADING_H
 
 #include "cjson/cJSON.h"
+#include "../scanner/http_headers_analyzer.h"
+#include <stdint.h>
 
+#define GRADING_RULES_ENV "GRADING_RULES_PATH"
+#define GRADING_RULES_DEFAULT_PATH "config/grading_rules.json"
+#define GRADING_NO_CAP -1
+
+typedef enum {
+  RULE_PRESENT,
+  RULE_ABSENT,
+  RULE_DIRECTIVE_MIN,
+  RULE_DIRECTIVE_MAX
+} grading_rule_kind;
+
+// One compiled rule; rules for the same header sit next to each other in the table
 typedef struct {
-  const char *header_name;
+  grading_rule_kind kind;
+  HeaderId id;
+  uint32_t name_hash;
+  char header[MAX_HEADER_NAME];
+  char directive[64];
+  long threshold;
   int weight;
-  int must_exist;
-} header_rule;
+  int cap;
+  Severity severity;
+  char note[256];
+} grading_rule;
+
+typedef struct {
+  int base_score;
+  int min_score;
+  int max_score;
+  int severity_weight[SEV_CRITICAL + 1];
+  grading_rule *rules;
+  size_t rule_count;
+  size_t known_first[HDR_COUNT];
+  size_t known_count[HDR_COUNT];
+  size_t unknown_first; // rules on headers outside HEADER_LIST run from here to rule_count
+} grading_ruleset;
 
 typedef struct {
   int score;
@@ -15,7 +48,12 @@ typedef struct {
   cJSON* notes;
 } grading_result;
 
-grading_result grading_analyze(const cJSON* headers_json);
+int grading_rules_init(const char *path);
+int grading_rules_reload_if_changed(void);
+void grading_rules_cleanup(void);
+void grading_score(const HeaderCollection *hc, const ReportList *rl, grading_result *result);
+
+grading_result grading_analyze(const HeaderCollection *hc, const char *url, const BodyInspector *body, const HttpScanConfig *config);
 
 void grading_result_free(grading_result *result);
 
@@ -0,0 +1,48 @@
+#ifndef BODY_INSPECTOR_H
+#define BODY_INSPECTOR_H
+
+#include "pattern_matcher.h"
+#include <stddef.h>
+
+#define BODY_MAGIC_BYTES 4
+#define BODY_MAX_SIZE_DEFAULT (1024 * 1024)
+#define BODY_MAX_SIZE_LIMIT (64 * 1024 * 1024)
+#define BODY_MAX_COMPRESSION_RATIO 200     // decoded:wire ratio treated as a decompression bomb ...
+#define BODY_RATIO_CHECK_MIN (1024 * 1024) // ... once this much has been decoded
+#define BODY_FINGERPRINT_PREFIX (16 * 1024) // body bytes a fingerprint covers
+
+typedef struct {
+    size_t max_size;
+    int stop_when_decided;
+    int headers_only; // abort at the first body byte; nothing below is filled in
+    const PatternMatcher* matcher;
+    size_t pattern_first; // only matches within [pattern_first, pattern_first + pattern_count) count
+    size_t pattern_count;
+
+    char magic[BODY_MAGIC_BYTES];
+    size_t magic_len;
+    char file_type[64];
+    int file_type_detected;
+    size_t total_size; // decoded bytes inspected
+    size_t wire_size;  // encoded bytes received for them, filled in by the transfer
+    int truncated;
+    int compression_bomb;
+    int stopped;
+    uint32_t match_state;
+    size_t matched;
+    long first_match; // pattern id, -1 until something matched
+    size_t first_match_end; // body offset just past the first match
+
+    int fingerprint; // when set, hash the body prefix with case, whitespace runs and digits normalized away
+    uint64_t fingerprint_hash;
+    size_t fingerprint_len;
+    int fingerprint_gap;
+} BodyInspector;
+
+void body_inspector_init(BodyInspector* bi, size_t max_size);
+void body_inspector_set_patterns(BodyInspector* bi, const PatternMatcher* matcher, size_t first, size_t count);
+int body_inspector_feed(BodyInspector* bi, const char* data, size_t len);
+void body_inspector_finish(BodyInspector* bi);
+int body_inspector_decided(const BodyInspector* bi);
+
+#endif
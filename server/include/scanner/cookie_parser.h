@@ -0,0 +1,49 @@
+#ifndef COOKIE_PARSER_H
+#define COOKIE_PARSER_H
+
+#include <stddef.h>
+
+#define COOKIE_MAX_AGE_LONG_LIVED (400L * 24 * 60 * 60) // browsers clamp persistence to 400 days
+
+// A view into the Set-Cookie header bytes; nothing is copied or terminated
+typedef struct {
+    const char* ptr;
+    size_t len;
+} CookieSpan;
+
+enum {
+    COOKIE_SECURE          = 1u << 0,
+    COOKIE_HTTPONLY        = 1u << 1,
+    COOKIE_SAMESITE_STRICT = 1u << 2,
+    COOKIE_SAMESITE_LAX    = 1u << 3,
+    COOKIE_SAMESITE_NONE   = 1u << 4,
+    COOKIE_HAS_DOMAIN      = 1u << 5,
+    COOKIE_HAS_PATH        = 1u << 6,
+    COOKIE_HAS_MAX_AGE     = 1u << 7,
+    COOKIE_HAS_EXPIRES     = 1u << 8,
+    COOKIE_PREFIX_SECURE   = 1u << 9,  // name starts with __Secure-
+    COOKIE_PREFIX_HOST     = 1u << 10  // name starts with __Host-
+};
+
+typedef struct {
+    CookieSpan name;
+    CookieSpan value;
+    CookieSpan domain;
+    CookieSpan path;
+    CookieSpan samesite;
+    long max_age;
+    unsigned flags;
+    size_t attr_count;
+} CookieInfo;
+
+// Reentrant cursor over the "; key[=value]" attributes following the name=value pair
+typedef struct {
+    const char* pos;
+    const char* end;
+} CookieAttrIter;
+
+int cookie_parse(const char* header, size_t len, CookieInfo* out);
+void cookie_attr_iter_init(CookieAttrIter* it, const char* header, size_t len);
+int cookie_attr_next(CookieAttrIter* it, CookieSpan* key, CookieSpan* value);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef CSP_H
+#define CSP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CSP_CACHE_SLOTS 256
+
+// Source expression kinds, OR-ed together per directive
+enum {
+    CSP_SRC_NONE           = 1u << 0,
+    CSP_SRC_SELF           = 1u << 1,
+    CSP_SRC_UNSAFE_INLINE  = 1u << 2,
+    CSP_SRC_UNSAFE_EVAL    = 1u << 3,
+    CSP_SRC_STRICT_DYNAMIC = 1u << 4,
+    CSP_SRC_UNSAFE_HASHES  = 1u << 5,
+    CSP_SRC_NONCE          = 1u << 6,
+    CSP_SRC_HASH           = 1u << 7,
+    CSP_SRC_WILDCARD       = 1u << 8,  // bare '*'
+    CSP_SRC_SCHEME_HTTP    = 1u << 9,  // 'http:' or 'https:' alone, i.e. any host
+    CSP_SRC_SCHEME_DATA    = 1u << 10,
+    CSP_SRC_SCHEME_OTHER   = 1u << 11,
+    CSP_SRC_HOST           = 1u << 12
+};
+
+// Directives the evaluator looks at; everything else is parsed but kept as CSP_DIR_OTHER
+typedef enum {
+    CSP_DIR_DEFAULT_SRC,
+    CSP_DIR_SCRIPT_SRC,
+    CSP_DIR_OBJECT_SRC,
+    CSP_DIR_BASE_URI,
+    CSP_DIR_KNOWN_COUNT,
+    CSP_DIR_OTHER = CSP_DIR_KNOWN_COUNT
+} CspDirectiveId;
+
+typedef struct {
+    uint32_t off;
+    uint32_t len;
+    unsigned kind;
+} CspSource;
+
+typedef struct {
+    uint32_t name_off;
+    uint32_t name_len;
+    CspDirectiveId id;
+    uint32_t first_source;
+    uint32_t source_count;
+    unsigned flags; // union of the kinds of its sources
+} CspDirective;
+
+// Directive -> source-list view over a private copy of the header value. Commas separate policies that
+// are all enforced; each keeps its own directive lookup.
+typedef struct {
+    char* text;
+    size_t text_len;
+    CspDirective* directives;
+    size_t directive_count;
+    CspSource* sources;
+    size_t source_count;
+    int (*by_id)[CSP_DIR_KNOWN_COUNT]; // per policy: index + 1 into directives, 0 when absent
+    size_t policy_count;
+} CspPolicy;
+
+enum {
+    CSP_ISSUE_NO_DEFAULT_SRC        = 1u << 0,
+    CSP_ISSUE_DEFAULT_SRC_RISKY     = 1u << 1,
+    CSP_ISSUE_SCRIPT_UNRESTRICTED   = 1u << 2,
+    CSP_ISSUE_SCRIPT_UNSAFE_INLINE  = 1u << 3,
+    CSP_ISSUE_SCRIPT_UNSAFE_EVAL    = 1u << 4,
+    CSP_ISSUE_SCRIPT_ANY_HOST       = 1u << 5,
+    CSP_ISSUE_SCRIPT_DATA           = 1u << 6,
+    CSP_ISSUE_OBJECT_NOT_NONE       = 1u << 7,
+    CSP_ISSUE_BASE_URI_MISSING      = 1u << 8,
+    CSP_ISSUE_STRICT_DYNAMIC_ALONE  = 1u << 9
+};
+
+// Effective policy after fallbacks and CSP3 keyword neutralisation, intersected across the header's policies
+typedef struct {
+    unsigned script;           // source kinds that actually apply to scripts
+    CspDirectiveId script_from;
+    unsigned object;
+    CspDirectiveId object_from;
+    unsigned base_uri;
+    int has_base_uri;
+    unsigned issues;
+} CspEvaluation;
+
+int csp_parse(const char* value, size_t len, CspPolicy* policy);
+void csp_policy_free(CspPolicy* policy);
+const CspDirective* csp_find_directive(const CspPolicy* policy, size_t index, CspDirectiveId id);
+void csp_evaluate(const CspPolicy* policy, CspEvaluation* out);
+int csp_evaluate_cached(const char* value, CspEvaluation* out);
+void csp_cache_clear(void);
+const char* csp_directive_name(CspDirectiveId id);
+
+#endif
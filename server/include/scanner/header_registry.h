@@ -0,0 +1,51 @@
+#ifndef HEADER_REGISTRY_H
+#define HEADER_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Every header name the analyzer knows about; adding a row here adds both the enum value and its lookup entry
+#define HEADER_LIST(X) \
+    X(STRICT_TRANSPORT_SECURITY, "strict-transport-security") \
+    X(CONTENT_SECURITY_POLICY, "content-security-policy") \
+    X(X_CONTENT_TYPE_OPTIONS, "x-content-type-options") \
+    X(X_FRAME_OPTIONS, "x-frame-options") \
+    X(REFERRER_POLICY, "referrer-policy") \
+    X(PERMISSIONS_POLICY, "permissions-policy") \
+    X(FEATURE_POLICY, "feature-policy") \
+    X(CACHE_CONTROL, "cache-control") \
+    X(PRAGMA, "pragma") \
+    X(EXPIRES, "expires") \
+    X(CONTENT_TYPE, "content-type") \
+    X(CONTENT_LANGUAGE, "content-language") \
+    X(CONTENT_ENCODING, "content-encoding") \
+    X(SET_COOKIE, "set-cookie") \
+    X(X_RATE_LIMIT, "x-rate-limit") \
+    X(X_RATELIMIT_LIMIT, "x-ratelimit-limit") \
+    X(X_RATELIMIT_REMAINING, "x-ratelimit-remaining") \
+    X(X_RATELIMIT_RESET, "x-ratelimit-reset") \
+    X(RATELIMIT, "ratelimit") \
+    X(RATELIMIT_POLICY, "ratelimit-policy") \
+    X(RATELIMIT_LIMIT, "ratelimit-limit") \
+    X(RATELIMIT_REMAINING, "ratelimit-remaining") \
+    X(RATELIMIT_RESET, "ratelimit-reset") \
+    X(RETRY_AFTER, "retry-after")
+
+#define HEADER_ENUM_ENTRY(id, name) HDR_##id,
+
+typedef enum {
+    HDR_UNKNOWN = 0,
+    HEADER_LIST(HEADER_ENUM_ENTRY)
+    HDR_COUNT
+} HeaderId;
+
+#define HEADER_HASH_SLOTS 64
+
+// Builds the lookup table; call once at startup, before any other function here. Returns -1 when no
+// collision-free seed exists, which means HEADER_HASH_SLOTS has to grow
+int header_registry_init(void);
+uint32_t header_name_hash(const char* name, size_t len);
+HeaderId header_lookup(const char* name, size_t len, uint32_t hash);
+const char* header_name(HeaderId id);
+
+#endif
@@ -1,25 +1,47 @@
 #ifndef HTTP_HEADERS_ANALYZER_H
 #define HTTP_HEADERS_ANALYZER_H
 
+#include "body_inspector.h"
+#include "header_registry.h"
 #include <cjson/cJSON.h>
+#include <curl/curl.h>
+#include <stddef.h>
 
 #define MAX_HEADER_NAME 128
-#define MAX_HEADER_VALUE 1024
-#define MAX_HEADERS 100
+#define HEADER_POOL_LIMIT (1024 * 1024)
 
 typedef enum { SEV_INFO, SEV_WARNING, SEV_CRITICAL } Severity;
 
 typedef struct {
-    char name[MAX_HEADER_NAME];
-    char value[MAX_HEADER_VALUE];
-    int duplicates;
+    uint32_t name_off;
+    uint32_t name_len;
+    uint32_t value_off;
+    uint32_t value_len;
+    uint32_t hash;
+    HeaderId id;
+    int first;      // index + 1 of the first header with the same name, its own for a first occurrence
+    int next;       // index + 1 of the next header with the same name, 0 at the end of the chain
+    int last;       // index + 1 of the chain's last header; set on the first occurrence only
+    int duplicates; // set on the first occurrence only
 } HttpHeader;
 
+// Names and values live NUL-terminated in one byte pool; records only hold offsets into it
 typedef struct {
-    HttpHeader headers[MAX_HEADERS];
+    char* pool;
+    size_t pool_len;
+    size_t pool_cap;
+    HttpHeader* headers;
     int count;
+    int capacity;
+    int by_id[HDR_COUNT]; // index + 1 of the first occurrence of each known header, 0 when absent
+    int* names;           // open-addressed by name hash: index + 1 of the first occurrence of each unknown name
+    int names_cap;        // power of two, 0 until the first unknown name
+    int names_used;
 } HeaderCollection;
 
+static inline const char* header_name_at(const HeaderCollection* hc, int i) { return hc->pool + hc->headers[i].name_off; }
+static inline const char* header_value_at(const HeaderCollection* hc, int i) { return hc->pool + hc->headers[i].value_off; }
+
 typedef struct ReportEntry {
     char message[1024];
     Severity severity;
@@ -41,28 +63,55 @@ typedef struct {
     int count;
 } DirectiveList;
 
+// Checks that need response bodies; with none enabled the scan never reads past the headers
+enum {
+    HTTP_CHECK_CONTENT_SNIFF = 1u << 0, // compare Content-Type with the body's magic bytes
+    HTTP_CHECK_INJECTION     = 1u << 1, // look for payload reflection in injection probe bodies
+    HTTP_CHECK_ALL           = HTTP_CHECK_CONTENT_SNIFF | HTTP_CHECK_INJECTION
+};
+
 typedef struct {
-    int score;
-    cJSON* missing;
-    cJSON* notes;
-} grading_result;
+    size_t max_body_size;
+    unsigned body_checks; // HTTP_CHECK_* bits
+    int burst_size;       // rate-limit burst length; 0 for the default
+    int burst_rate;       // burst requests per second; 0 sends them all at once
+    int revalidate; // send stored validators and reuse body findings on 304
+    int http2;      // multiplex every transfer of the analysis over one HTTP/2 connection where possible
+    CURLSH* share;  // connection cache shared by those transfers, set up by http_scan_config_enable_http2
+} HttpScanConfig;
+
+// Non-negative results of http_fetch_url, relative to the previous scan of the same URL
+typedef enum {
+    HTTP_FETCH_NEW,          // no earlier scan on record
+    HTTP_FETCH_NOT_MODIFIED, // 304: body findings reused from the earlier scan
+    HTTP_FETCH_UNCHANGED,    // full response with the earlier scan's ETag or Last-Modified, or the same inspected bytes
+    HTTP_FETCH_CHANGED
+} HttpFetchStatus;
 
+int http_analyzer_init(void);
+void http_analyzer_cleanup(void);
 void report_init(ReportList* rl);
 void report_add(ReportList* rl, Severity sev, const char* fmt, ...);
 void report_print_and_free(ReportList* rl);
-int http_fetch_url(const char* url, cJSON** out_headers, char** out_html);
+const char* http_body_check_name(unsigned check);
+int http_scan_config_enable_http2(HttpScanConfig* config);
+void http_scan_config_free(HttpScanConfig* config);
+int http_fetch_url(const char* url, const HttpScanConfig* config, HeaderCollection* out_headers, BodyInspector* out_body);
 void normalize_name(char* dst, const char* src);
 void trim_whitespace(char** str_ptr);
-int find_header(HeaderCollection* hc, const char* name);
+int find_header(const HeaderCollection* hc, const char* name);
+int find_header_id(const HeaderCollection* hc, HeaderId id);
+void header_collection_reset(HeaderCollection* hc);
+void header_collection_free(HeaderCollection* hc);
 void add_header(HeaderCollection* hc, const char* name_raw, const char* value_raw);
+void add_header_n(HeaderCollection* hc, const char* name_raw, size_t name_len, const char* value_raw, size_t value_len);
+cJSON* header_collection_to_json(const HeaderCollection* hc);
 void parse_raw_headers(const char* raw_headers, HeaderCollection* hc);
 void detect_file_type(const char* data, size_t size, char* file_type, size_t file_type_len);
-void analyze_content_type(const char* value, const char* body, size_t body_size, ReportList* rl);
-void analyze_rate_limiting(const char* url, ReportList* rl);
-void analyze_xss_sql_injection(const char* url, ReportList* rl);
+void analyze_content_type(const char* value, const char* file_type, ReportList* rl);
+void analyze_rate_limiting(const char* url, const HttpScanConfig* config, ReportList* rl);
+void analyze_xss_sql_injection(const char* url, const HttpScanConfig* config, ReportList* rl);
 void analyze_cookies(const HeaderCollection* hc, ReportList* rl);
-grading_result grading_analyze(cJSON* headers_json, const char* url, char* body, size_t body_size);
-void grading_result_free(grading_result* result);
 int strcasestr_exists(const char* haystack, const char* needle);
 void parse_directives(const char* header_value, DirectiveList* dl);
 const char* get_directive_value(const DirectiveList* dl, const char* key);
@@ -74,6 +123,7 @@ void analyze_referrer_policy(const char* value, ReportList* rl);
 void analyze_feature_policy(const char* value, ReportList* rl);
 void analyze_cache_headers(const char* cache_control, const char* pragma, const char* expires, ReportList* rl);
 void analyze_content_language(const char* value, ReportList* rl);
+void analyze_compression(const char* encoding, const BodyInspector* body, ReportList* rl);
 void analyze_security_headers_presence(const HeaderCollection* hc, ReportList* rl);
 
 #endif
\ No newline at end of file
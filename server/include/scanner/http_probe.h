@@ -0,0 +1,57 @@
+#ifndef HTTP_PROBE_H
+#define HTTP_PROBE_H
+
+#include "body_inspector.h"
+#include "http_headers_analyzer.h"
+#include <curl/curl.h>
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROBE_MAX_PER_ORIGIN 4
+#define PROBE_TIMEOUT_S 10L
+#define PROBE_POLL_TIMEOUT_MS 100
+#define PROBE_DIGEST_SIZE 32
+
+typedef struct {
+    CURL* easy;
+    BodyInspector body;
+    HeaderCollection headers;
+    long http_code;
+    CURLcode result;
+    int done;
+    struct curl_slist* request_headers;
+    EVP_MD_CTX* digest; // SHA-256 over the body bytes inspected, when enabled
+    unsigned char body_digest[PROBE_DIGEST_SIZE];
+    int has_digest;
+    long http_version;    // CURL_HTTP_VERSION_* actually negotiated
+    long new_connections; // connections this transfer had to open; 0 when it reused or multiplexed
+    curl_off_t pretransfer_us; // libcurl's monotonic timings, relative to the transfer start
+    curl_off_t ttfb_us;
+    curl_off_t total_us;
+} HttpProbe;
+
+typedef struct {
+    CURLM* multi;
+    HttpProbe** probes;
+    size_t count;
+    size_t capacity;
+    size_t max_body_size;
+    int running;
+    int multiplex;
+    CURLSH* share;
+} ProbeBatch;
+
+int probe_batch_init(ProbeBatch* pb, long max_per_origin, size_t max_body_size);
+void probe_batch_enable_http2(ProbeBatch* pb, CURLSH* share);
+CURLSH* probe_share_init(void);
+void probe_share_free(CURLSH* share);
+HttpProbe* probe_batch_add(ProbeBatch* pb, const char* url, long timeout_s);
+int probe_set_validators(HttpProbe* probe, const char* etag, const char* last_modified);
+int probe_track_digest(HttpProbe* probe);
+int probe_batch_step(ProbeBatch* pb);
+void probe_batch_wait(ProbeBatch* pb);
+void probe_batch_free(ProbeBatch* pb);
+uint64_t probe_monotonic_ns(void);
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef INJECTION_ENGINE_H
+#define INJECTION_ENGINE_H
+
+#include "http_headers_analyzer.h"
+#include "http_probe.h"
+#include "pattern_matcher.h"
+#include <stddef.h>
+
+#define INJECTION_PAYLOADS_ENV "INJECTION_PAYLOADS_PATH"
+#define INJECTION_PAYLOADS_DEFAULT_PATH "config/injection_payloads.json"
+#define INJECTION_MAX_PARAMS 16
+#define INJECTION_MAX_PROBES 256
+#define INJECTION_DEFAULT_PARAM "test"
+
+typedef struct {
+    char* payload;
+    char* kind;
+    size_t signature_first; // contiguous range of this payload's signatures in the corpus matcher
+    size_t signature_count;
+} InjectionPayload;
+
+// Payloads and their response signatures; read-only once loaded
+typedef struct {
+    InjectionPayload* payloads;
+    size_t payload_count;
+    char** signatures;
+    size_t signature_count;
+    PatternMatcher matcher;
+} InjectionCorpus;
+
+typedef struct {
+    HttpProbe* probe;
+    size_t payload;
+    char param[64];
+} InjectionProbe;
+
+// One URL's worth of probes: an unmodified baseline plus every (parameter, payload) pair
+typedef struct {
+    HttpProbe* baseline;
+    InjectionProbe* probes;
+    size_t count;
+    size_t param_count;
+    int params_truncated; // more than INJECTION_MAX_PARAMS names; the rest are sent unchanged but not tested
+    int truncated;        // the pair count hit INJECTION_MAX_PROBES
+} InjectionScan;
+
+int injection_corpus_init(const char* path);
+const InjectionCorpus* injection_corpus_get(void);
+void injection_corpus_cleanup(void);
+
+int injection_scan_schedule(InjectionScan* scan, ProbeBatch* pb, const char* url);
+void injection_scan_evaluate(const InjectionScan* scan, ReportList* rl);
+void injection_scan_free(InjectionScan* scan);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PATTERN_MATCHER_H
+#define PATTERN_MATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PATTERN_MATCHER_START 0
+
+// Case-insensitive Aho-Corasick automaton compiled to a dense DFA over byte classes
+typedef struct {
+    size_t pattern_count;
+    size_t state_count;
+    size_t class_count;
+    uint8_t byte_class[256];  // byte -> column in delta; 0 for bytes that appear in no pattern
+    uint32_t* delta;          // state_count * class_count transitions
+    uint32_t* out_offset;     // state_count + 1 offsets into out_ids
+    uint32_t* out_ids;        // pattern ids ending at each state, suffix matches included
+} PatternMatcher;
+
+// Returning non-zero stops the scan early
+typedef int (*PatternMatchFn)(size_t pattern_id, size_t end_offset, void* ctx);
+
+int pattern_matcher_build(PatternMatcher* pm, const char* const* patterns, size_t count);
+void pattern_matcher_free(PatternMatcher* pm);
+uint32_t pattern_matcher_scan(const PatternMatcher* pm, uint32_t state, const char* data, size_t len,
+                              PatternMatchFn on_match, void* ctx);
+void pattern_matcher_mark(const PatternMatcher* pm, const char* data, size_t len, unsigned char* hits);
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include "http_headers_analyzer.h"
+#include "http_probe.h"
+#include <stdint.h>
+
+#define RATE_LIMIT_BURST_DEFAULT 10
+#define RATE_LIMIT_BURST_MAX 500
+#define RATE_LIMIT_RATE_MAX 1000
+#define RATE_LIMIT_MAX_PER_ORIGIN RATE_LIMIT_BURST_MAX // connection cap of a burst's own batch, so no request queues
+#define RATE_LIMIT_INFLATION_RATIO 3      // p99 at least this many times p50 ...
+#define RATE_LIMIT_INFLATION_MIN_US 50000 // ... and at least this much slower, to count as inflation
+
+// N requests to one URL, either all handed to the batch at once or released at a fixed rate. The batch
+// should hold nothing else, or other traffic shows up in the burst's latencies.
+typedef struct {
+    char* url;
+    HttpProbe** probes;
+    int size;
+    int sent;
+    int rate;          // requests per second; 0 sends the whole burst at once
+    uint64_t start_ns; // CLOCK_MONOTONIC at the first send
+} RateLimitBurst;
+
+int rate_limit_burst_start(RateLimitBurst* burst, ProbeBatch* pb, const char* url, int size, int rate);
+long rate_limit_burst_pump(RateLimitBurst* burst, ProbeBatch* pb);
+void rate_limit_burst_wait(RateLimitBurst* burst, ProbeBatch* pb);
+void rate_limit_burst_evaluate(const RateLimitBurst* burst, ReportList* rl);
+void rate_limit_burst_free(RateLimitBurst* burst);
+
+#endif
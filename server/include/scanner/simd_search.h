@@ -0,0 +1,18 @@
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+#include <stddef.h>
+
+typedef const char* (*CasefindFn)(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len);
+
+// ASCII case-insensitive substring search; returns the first match or NULL. Dispatches to AVX2/SSE2 when available.
+const char* simd_casefind(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len);
+const char* simd_casefind_impl_name(void);
+
+// Individual kernels, exposed for benchmarks; unsupported ones resolve to NULL
+const char* simd_casefind_scalar(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len);
+extern const CasefindFn simd_casefind_sse2_fn;
+extern const CasefindFn simd_casefind_avx2_fn;
+int simd_casefind_avx2_supported(void);
+
+#endif
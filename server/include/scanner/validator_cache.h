@@ -0,0 +1,33 @@
+#ifndef VALIDATOR_CACHE_H
+#define VALIDATOR_CACHE_H
+
+#include "body_inspector.h"
+#include "http_headers_analyzer.h"
+#include "http_probe.h"
+#include <stddef.h>
+#include <time.h>
+
+#define VALIDATOR_CACHE_SLOTS 256
+#define VALIDATOR_MAX_ETAG 256
+#define VALIDATOR_MAX_DATE 64
+#define VALIDATOR_MAX_AGE_S (24 * 60 * 60) // body findings older than this are re-derived from a full fetch
+
+// What the last full (2xx) fetch of a URL left behind: its validators and everything derived from its body
+typedef struct {
+    char etag[VALIDATOR_MAX_ETAG];
+    char last_modified[VALIDATOR_MAX_DATE];
+    unsigned char digest[PROBE_DIGEST_SIZE];
+    int has_digest;
+    BodyInspector body;
+    HeaderCollection headers; // owned copy of the stored response headers
+    time_t stored_at; // time of the full fetch the body findings come from
+} ValidatorEntry;
+
+int validator_cache_lookup(const char* url, ValidatorEntry* out);
+void validator_cache_store(const char* url, const HeaderCollection* headers, const BodyInspector* body, const unsigned char* digest);
+void validator_cache_refresh(const char* url, const ValidatorEntry* entry, const HeaderCollection* merged);
+void validator_cache_merge_304(const ValidatorEntry* entry, const HeaderCollection* not_modified, HeaderCollection* out);
+void validator_entry_free(ValidatorEntry* entry);
+void validator_cache_clear(void);
+
+#endif
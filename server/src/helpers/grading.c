@@ -1,78 +1,372 @@
-// #include "../../include/helpers/grading.h"
-//
-// #include <stdio.h>
-// #include <string.h>
-//
-// static header_rule rules[] = {
-//     {"Strict-Transport-Security", 30, 1},
-//     {"Content-Security-Policy", 30, 1},
-//     {"X-Frame-Options", 20, 1},
-//     {"X-Content-Type-Options", 10, 1},
-//     {"Referrer-Policy", 10, 1},
-//     {"Feature-Policy", 5, 0},
-//     {"Server", 0, -1}
-// };
-//
-// #define RULES_COUNT (sizeof(rules) / sizeof(rules[0]))
-// #define MAX_SCORE 100
-//
-// static int header_present(const cJSON* header_json, const char* header_name) {
-//     const cJSON* item = cJSON_GetObjectItemCaseSensitive((cJSON*)header_json, header_name);
-//
-//     return (item != NULL);
-// }
-//
-// grading_result grading_analyze(const cJSON* headers_json) {
-//     grading_result result = {0};
-//     result.score = MAX_SCORE;
-//     result.missing = cJSON_CreateArray();
-//     result.notes = cJSON_CreateArray();
-//
-//     for (size_t i = 0; i < RULES_COUNT; i++) {
-//         const header_rule* rule = &rules[i];
-//         int present = header_present(headers_json, rule->header_name);
-//
-//         if (rule->must_exist == 1 && !present) {
-//             result.score -= rule->weight;
-//
-//             cJSON_AddItemToArray(result.missing, cJSON_CreateString(rule->header_name));
-//
-//             char note_buf[256];
-//             snprintf(note_buf, sizeof(note_buf), "Missing important security header: %s", rule->header_name);
-//             cJSON_AddItemToArray(result.notes, cJSON_CreateString(note_buf));
-//         }
-//         else if (rule->must_exist == -1 && present) {
-//             result.score -= rule->weight;
-//
-//             cJSON_AddItemToArray(result.missing, cJSON_CreateString(rule->header_name));
-//             cJSON_AddItemToArray(result.notes, cJSON_CreateString("Header should be absent for security reasons"));
-//         }
-//         else if (rule->must_exist == 0 && !present) {
-//             result.score -= rule->weight;
-//         }
-//     }
-//
-//     if (result.score < 0) {
-//         result.score = 0;
-//     }
-//
-//     if (result.score > MAX_SCORE) {
-//         result.score = MAX_SCORE;
-//     }
-//
-//     return result;
-// }
-//
-// void grading_result_free(grading_result* result) {
-//     if (!result) {
-//         return;
-//     }
-//
-//     if (result->missing) {
-//         cJSON_Delete(result->missing);
-//     }
-//
-//     if (result->notes) {
-//         cJSON_Delete(result->notes);
-//     }
-// }
\ No newline at end of file
+#include "../../include/helpers/grading.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#define MAX_SCORE 100
+#define GRADING_RULES_MAX_FILE (1024 * 1024)
+
+static grading_ruleset* active_rules;
+static pthread_rwlock_t rules_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_mutex_t reload_lock = PTHREAD_MUTEX_INITIALIZER;
+static char rules_path[4096];
+static struct timespec rules_mtime;
+static off_t rules_size;
+
+static void ruleset_free(grading_ruleset* set) {
+    if (!set) {
+        return;
+    }
+    free(set->rules);
+    free(set);
+}
+
+// Used when no rules file can be read: reproduces the fixed per-severity deductions
+static grading_ruleset* ruleset_default(void) {
+    grading_ruleset* set = calloc(1, sizeof(*set));
+    if (!set) {
+        return NULL;
+    }
+    set->base_score = MAX_SCORE;
+    set->min_score = 0;
+    set->max_score = MAX_SCORE;
+    set->severity_weight[SEV_CRITICAL] = 50;
+    set->severity_weight[SEV_WARNING] = 10;
+    return set;
+}
+
+static int json_int(const cJSON* obj, const char* key, int fallback) {
+    const cJSON* item = cJSON_GetObjectItemCaseSensitive(obj, key);
+    return cJSON_IsNumber(item) ? item->valueint : fallback;
+}
+
+static int parse_severity(const char* name, Severity* out) {
+    if (strcasecmp(name, "critical") == 0) *out = SEV_CRITICAL;
+    else if (strcasecmp(name, "warning") == 0) *out = SEV_WARNING;
+    else if (strcasecmp(name, "info") == 0) *out = SEV_INFO;
+    else return -1;
+    return 0;
+}
+
+static int parse_kind(const char* name, grading_rule_kind* out) {
+    if (strcmp(name, "present") == 0) *out = RULE_PRESENT;
+    else if (strcmp(name, "absent") == 0) *out = RULE_ABSENT;
+    else if (strcmp(name, "directive_min") == 0) *out = RULE_DIRECTIVE_MIN;
+    else if (strcmp(name, "directive_max") == 0) *out = RULE_DIRECTIVE_MAX;
+    else return -1;
+    return 0;
+}
+
+static int compile_rule(const cJSON* item, size_t index, grading_rule* rule) {
+    const cJSON* header = cJSON_GetObjectItemCaseSensitive(item, "header");
+    const cJSON* check = cJSON_GetObjectItemCaseSensitive(item, "check");
+    if (!cJSON_IsString(header) || !cJSON_IsString(check) || parse_kind(check->valuestring, &rule->kind) != 0) {
+        fprintf(stderr, "Grading rule %zu: needs 'header' and a valid 'check'\n", index);
+        return -1;
+    }
+
+    memset(rule->header, 0, sizeof(rule->header));
+    size_t len = strlen(header->valuestring);
+    if (len == 0 || len >= sizeof(rule->header)) {
+        fprintf(stderr, "Grading rule %zu: bad header name\n", index);
+        return -1;
+    }
+    normalize_name(rule->header, header->valuestring);
+    rule->name_hash = header_name_hash(rule->header, len);
+    rule->id = header_lookup(rule->header, len, rule->name_hash);
+
+    rule->directive[0] = 0;
+    if (rule->kind == RULE_DIRECTIVE_MIN || rule->kind == RULE_DIRECTIVE_MAX) {
+        const cJSON* directive = cJSON_GetObjectItemCaseSensitive(item, "directive");
+        const cJSON* value = cJSON_GetObjectItemCaseSensitive(item, "value");
+        if (!cJSON_IsString(directive) || !cJSON_IsNumber(value)) {
+            fprintf(stderr, "Grading rule %zu: directive checks need 'directive' and numeric 'value'\n", index);
+            return -1;
+        }
+        snprintf(rule->directive, sizeof(rule->directive), "%s", directive->valuestring);
+        rule->threshold = (long)value->valuedouble;
+    }
+
+    rule->weight = json_int(item, "weight", 0);
+    rule->cap = json_int(item, "cap", GRADING_NO_CAP);
+    rule->severity = SEV_WARNING;
+    const cJSON* severity = cJSON_GetObjectItemCaseSensitive(item, "severity");
+    if (cJSON_IsString(severity) && parse_severity(severity->valuestring, &rule->severity) != 0) {
+        fprintf(stderr, "Grading rule %zu: unknown severity '%s'\n", index, severity->valuestring);
+        return -1;
+    }
+
+    const cJSON* note = cJSON_GetObjectItemCaseSensitive(item, "note");
+    if (cJSON_IsString(note)) {
+        snprintf(rule->note, sizeof(rule->note), "%s", note->valuestring);
+    } else if (rule->kind == RULE_PRESENT) {
+        snprintf(rule->note, sizeof(rule->note), "Missing important security header: %s", rule->header);
+    } else if (rule->kind == RULE_ABSENT) {
+        snprintf(rule->note, sizeof(rule->note), "Header %s should be absent for security reasons", rule->header);
+    } else {
+        snprintf(rule->note, sizeof(rule->note), "%s %s is %s %ld", rule->header, rule->directive,
+                 rule->kind == RULE_DIRECTIVE_MIN ? "below" : "above", rule->threshold);
+    }
+    return 0;
+}
+
+// Known headers first, grouped by HeaderId; unknown ones after, grouped by hash
+static int rule_order(const void* a, const void* b) {
+    const grading_rule* ra = a, *rb = b;
+    int unknown_a = ra->id == HDR_UNKNOWN, unknown_b = rb->id == HDR_UNKNOWN;
+    if (unknown_a != unknown_b) return unknown_a - unknown_b;
+    if (ra->id != rb->id) return (int)ra->id - (int)rb->id;
+    if (ra->name_hash != rb->name_hash) return ra->name_hash < rb->name_hash ? -1 : 1;
+    return strcmp(ra->header, rb->header);
+}
+
+static grading_ruleset* ruleset_compile(const cJSON* root) {
+    grading_ruleset* set = ruleset_default();
+    if (!set) {
+        return NULL;
+    }
+    set->base_score = json_int(root, "base_score", set->base_score);
+    set->min_score = json_int(root, "min_score", set->min_score);
+    set->max_score = json_int(root, "max_score", set->max_score);
+
+    const cJSON* weights = cJSON_GetObjectItemCaseSensitive(root, "severity_weights");
+    if (cJSON_IsObject(weights)) {
+        set->severity_weight[SEV_CRITICAL] = json_int(weights, "critical", set->severity_weight[SEV_CRITICAL]);
+        set->severity_weight[SEV_WARNING] = json_int(weights, "warning", set->severity_weight[SEV_WARNING]);
+        set->severity_weight[SEV_INFO] = json_int(weights, "info", set->severity_weight[SEV_INFO]);
+    }
+
+    const cJSON* rules = cJSON_GetObjectItemCaseSensitive(root, "rules");
+    size_t count = cJSON_IsArray(rules) ? (size_t)cJSON_GetArraySize(rules) : 0;
+    if (count) {
+        set->rules = calloc(count, sizeof(*set->rules));
+        if (!set->rules) {
+            ruleset_free(set);
+            return NULL;
+        }
+        const cJSON* item = NULL;
+        cJSON_ArrayForEach(item, rules) {
+            if (compile_rule(item, set->rule_count, &set->rules[set->rule_count]) != 0) {
+                ruleset_free(set);
+                return NULL;
+            }
+            set->rule_count++;
+        }
+        qsort(set->rules, set->rule_count, sizeof(*set->rules), rule_order);
+    }
+
+    set->unknown_first = set->rule_count;
+    for (size_t i = set->rule_count; i-- > 0;) {
+        HeaderId id = set->rules[i].id;
+        if (id == HDR_UNKNOWN) {
+            set->unknown_first = i;
+            continue;
+        }
+        set->known_first[id] = i;
+        set->known_count[id]++;
+    }
+    return set;
+}
+
+static grading_ruleset* ruleset_load(const char* path, struct stat* st) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    if (fstat(fileno(fp), st) != 0 || st->st_size <= 0 || st->st_size > GRADING_RULES_MAX_FILE) {
+        fprintf(stderr, "Grading rules file %s is empty or too large\n", path);
+        fclose(fp);
+        return NULL;
+    }
+
+    char* text = malloc((size_t)st->st_size + 1);
+    if (!text) {
+        fclose(fp);
+        return NULL;
+    }
+    size_t n = fread(text, 1, (size_t)st->st_size, fp);
+    fclose(fp);
+    text[n] = 0;
+
+    cJSON* root = cJSON_Parse(text);
+    free(text);
+    if (!root) {
+        fprintf(stderr, "Grading rules file %s is not valid JSON\n", path);
+        return NULL;
+    }
+    grading_ruleset* set = ruleset_compile(root);
+    cJSON_Delete(root);
+    return set;
+}
+
+static void ruleset_swap(grading_ruleset* set) {
+    pthread_rwlock_wrlock(&rules_lock);
+    grading_ruleset* old = active_rules;
+    active_rules = set;
+    pthread_rwlock_unlock(&rules_lock);
+    ruleset_free(old);
+}
+
+// Loads rules from path, $GRADING_RULES_PATH or the default location; falls back to built-in weights if none load
+int grading_rules_init(const char* path) {
+    if (!path) path = getenv(GRADING_RULES_ENV);
+    if (!path) path = GRADING_RULES_DEFAULT_PATH;
+    snprintf(rules_path, sizeof(rules_path), "%s", path);
+
+    struct stat st;
+    grading_ruleset* set = ruleset_load(rules_path, &st);
+    if (!set) {
+        fprintf(stderr, "Using built-in grading weights; could not load %s\n", rules_path);
+        memset(&rules_mtime, 0, sizeof(rules_mtime));
+        rules_size = 0;
+        ruleset_swap(ruleset_default());
+        return -1;
+    }
+    rules_mtime = st.st_mtim;
+    rules_size = st.st_size;
+    ruleset_swap(set);
+    return 0;
+}
+
+// Cheap enough to call per request: one stat(), and a reload only when the file actually changed
+int grading_rules_reload_if_changed(void) {
+    struct stat st;
+    if (!rules_path[0] || stat(rules_path, &st) != 0) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&reload_lock);
+    if (st.st_mtim.tv_sec == rules_mtime.tv_sec && st.st_mtim.tv_nsec == rules_mtime.tv_nsec && st.st_size == rules_size) {
+        pthread_mutex_unlock(&reload_lock);
+        return 0;
+    }
+
+    // Remember the attempt even when it fails so a broken file is not re-parsed on every request
+    rules_mtime = st.st_mtim;
+    rules_size = st.st_size;
+    grading_ruleset* set = ruleset_load(rules_path, &st);
+    if (!set) {
+        pthread_mutex_unlock(&reload_lock);
+        fprintf(stderr, "Keeping previous grading rules; reload of %s failed\n", rules_path);
+        return -1;
+    }
+    fprintf(stderr, "Reloaded %zu grading rules from %s\n", set->rule_count, rules_path);
+    ruleset_swap(set);
+    pthread_mutex_unlock(&reload_lock);
+    return 1;
+}
+
+void grading_rules_cleanup(void) {
+    ruleset_swap(NULL);
+}
+
+static void evaluate_header(const grading_ruleset* set, const grading_rule* rule, const char* value, unsigned char* failed) {
+    size_t index = (size_t)(rule - set->rules);
+    switch (rule->kind) {
+        case RULE_PRESENT:
+            failed[index] = 0;
+            break;
+        case RULE_ABSENT:
+            failed[index] = 1;
+            break;
+        case RULE_DIRECTIVE_MIN:
+        case RULE_DIRECTIVE_MAX: {
+            DirectiveList dl;
+            parse_directives(value, &dl);
+            const char* raw = get_directive_value(&dl, rule->directive);
+            if (raw && *raw == '"') raw++;
+            long v = raw ? strtol(raw, NULL, 10) : 0;
+            failed[index] = !raw || (rule->kind == RULE_DIRECTIVE_MIN ? v < rule->threshold : v > rule->threshold);
+            break;
+        }
+    }
+}
+
+static void apply_rules(const grading_ruleset* set, const HeaderCollection* hc, unsigned char* failed) {
+    // Presence rules fail until their header shows up; the rest only apply to headers that are there
+    for (size_t r = 0; r < set->rule_count; r++) {
+        failed[r] = set->rules[r].kind == RULE_PRESENT;
+    }
+
+    for (int i = 0; i < hc->count; i++) {
+        const HttpHeader* hdr = &hc->headers[i];
+        if (hdr->first != i + 1) continue; // repeated header, already graded
+        size_t first, count;
+        if (hdr->id != HDR_UNKNOWN) {
+            first = set->known_first[hdr->id];
+            count = set->known_count[hdr->id];
+        } else {
+            first = set->unknown_first;
+            count = set->rule_count - set->unknown_first;
+        }
+        for (size_t r = first; r < first + count; r++) {
+            const grading_rule* rule = &set->rules[r];
+            if (hdr->id == HDR_UNKNOWN && (rule->name_hash != hdr->hash || strcmp(rule->header, header_name_at(hc, i)) != 0)) continue;
+            evaluate_header(set, rule, header_value_at(hc, i), failed);
+        }
+    }
+}
+
+void grading_score(const HeaderCollection* hc, const ReportList* rl, grading_result* result) {
+    grading_rules_reload_if_changed();
+
+    pthread_rwlock_rdlock(&rules_lock);
+    const grading_ruleset* set = active_rules;
+    grading_ruleset fallback = {0};
+    if (!set) {
+        // grading_rules_init() was never called; grade with the built-in weights
+        fallback.base_score = MAX_SCORE;
+        fallback.max_score = MAX_SCORE;
+        fallback.severity_weight[SEV_CRITICAL] = 50;
+        fallback.severity_weight[SEV_WARNING] = 10;
+        set = &fallback;
+    }
+
+    int score = set->base_score;
+    for (const ReportEntry* entry = rl->head; entry; entry = entry->next) {
+        score -= set->severity_weight[entry->severity];
+        cJSON* target = entry->severity == SEV_CRITICAL ? result->missing : result->notes;
+        cJSON_AddItemToArray(target, cJSON_CreateString(entry->message));
+    }
+
+    int cap = GRADING_NO_CAP;
+    unsigned char* failed = set->rule_count ? calloc(set->rule_count, 1) : NULL;
+    if (failed) {
+        apply_rules(set, hc, failed);
+        for (size_t r = 0; r < set->rule_count; r++) {
+            if (!failed[r]) continue;
+            const grading_rule* rule = &set->rules[r];
+            score -= rule->weight;
+            if (rule->cap != GRADING_NO_CAP && (cap == GRADING_NO_CAP || rule->cap < cap)) cap = rule->cap;
+            cJSON* target = rule->severity == SEV_CRITICAL ? result->missing : result->notes;
+            cJSON_AddItemToArray(target, cJSON_CreateString(rule->note));
+        }
+        free(failed);
+    }
+
+    if (score < set->min_score) score = set->min_score;
+    if (score > set->max_score) score = set->max_score;
+    if (cap != GRADING_NO_CAP && score > cap) score = cap;
+    result->score = score;
+    pthread_rwlock_unlock(&rules_lock);
+}
+
+void grading_result_free(grading_result* result) {
+    if (!result) {
+        return;
+    }
+
+    if (result->missing) {
+        cJSON_Delete(result->missing);
+        result->missing = NULL;
+    }
+
+    if (result->notes) {
+        cJSON_Delete(result->notes);
+        result->notes = NULL;
+    }
+}
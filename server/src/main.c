@@ -12,6 +12,7 @@
 #include <regex.h>
 #include "../include/scanner/network_analyzer.h"
 #include "../include/scanner/http_headers_analyzer.h"
+#include "../include/helpers/grading.h"
 #include <cjson/cJSON.h>
 
 #define SOCKET_PATH "/tmp/analyzer.sock"
@@ -105,18 +106,52 @@ static cJSON *na_report_list_to_json(NAReportList *restrict rl) {
     return array;
 }
 
-static void process_http(const char *restrict url, cJSON *restrict response, ReportList *restrict rl) {
-    cJSON *headers_json = NULL;
-    char *html = NULL;
+static void process_http(const char *restrict url, const cJSON *request, cJSON *restrict response, ReportList *restrict rl) {
+    HeaderCollection headers = {0};
+    BodyInspector body;
+    HttpScanConfig config = { .max_body_size = BODY_MAX_SIZE_DEFAULT, .body_checks = HTTP_CHECK_ALL, .revalidate = 1 };
 
-    if (http_fetch_url(url, &headers_json, &html) != 0) {
+    // Optional per-request cap on how much of each response body is read
+    const cJSON *max_body_json = cJSON_GetObjectItemCaseSensitive(request, "max_body_size");
+    if (cJSON_IsNumber(max_body_json) && max_body_json->valuedouble > 0) {
+        config.max_body_size = max_body_json->valuedouble < BODY_MAX_SIZE_LIMIT ? (size_t)max_body_json->valuedouble : BODY_MAX_SIZE_LIMIT;
+    }
+
+    // Rate-limit burst shape: how many requests, and optionally a fixed send rate instead of all at once
+    const cJSON *burst_size_json = cJSON_GetObjectItemCaseSensitive(request, "burst_size");
+    if (cJSON_IsNumber(burst_size_json)) config.burst_size = burst_size_json->valueint;
+    const cJSON *burst_rate_json = cJSON_GetObjectItemCaseSensitive(request, "burst_rate");
+    if (cJSON_IsNumber(burst_rate_json)) config.burst_rate = burst_rate_json->valueint;
+
+    // Body-dependent checks to run; an empty list makes a header-only scan that never reads a body
+    const cJSON *checks_json = cJSON_GetObjectItemCaseSensitive(request, "body_checks");
+    if (cJSON_IsArray(checks_json)) {
+        config.body_checks = 0;
+        const cJSON *check;
+        cJSON_ArrayForEach(check, checks_json) {
+            for (unsigned bit = 1; bit & HTTP_CHECK_ALL; bit <<= 1) {
+                if (cJSON_IsString(check) && strcmp(check->valuestring, http_body_check_name(bit)) == 0) config.body_checks |= bit;
+            }
+        }
+    }
+
+    // Repeat scans revalidate against the previous one unless the client opts out
+    if (cJSON_IsFalse(cJSON_GetObjectItemCaseSensitive(request, "revalidate"))) config.revalidate = 0;
+    // Opt-in: the fetch and every probe share one connection, multiplexed when the origin negotiates h2
+    if (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(request, "http2")) && http_scan_config_enable_http2(&config) != 0) {
+        report_add(rl, SEV_WARNING, "HTTP/2 mode unavailable, using separate HTTP/1.1 connections");
+    }
+
+    int fetch_status = http_fetch_url(url, &config, &headers, &body);
+    if (fetch_status < 0) {
         report_add(rl, SEV_CRITICAL, "Failed to fetch URL: %s", url);
         cJSON_AddStringToObject(response, "status", "error");
         cJSON_AddItemToObject(response, "request", report_list_to_json(rl));
+        http_scan_config_free(&config);
         return;
     }
 
-    grading_result gr = grading_analyze(headers_json, url, html, html ? strlen(html) : 0);
+    grading_result gr = grading_analyze(&headers, url, &body, &config);
     cJSON *report = report_list_to_json(rl);
     cJSON_AddStringToObject(response, "status", "success");
     cJSON_AddItemToObject(response, "report", report);
@@ -124,11 +159,30 @@ static void process_http(const char *restrict url, cJSON *restrict response, Rep
     cJSON_AddNumberToObject(grading, "score", gr.score);
     if (gr.missing) cJSON_AddItemToObject(grading, "missing", gr.missing);
     if (gr.notes) cJSON_AddItemToObject(grading, "notes", gr.notes);
+    gr.missing = gr.notes = NULL; // now owned by the response
     cJSON_AddItemToObject(response, "grading", grading);
 
+    cJSON *skipped = cJSON_AddArrayToObject(response, "skipped_checks");
+    for (unsigned bit = 1; bit & HTTP_CHECK_ALL; bit <<= 1) {
+        if (!(config.body_checks & bit)) cJSON_AddItemToArray(skipped, cJSON_CreateString(http_body_check_name(bit)));
+    }
+
+    static const char *const fetch_status_names[] = {
+        [HTTP_FETCH_NEW] = "new",
+        [HTTP_FETCH_NOT_MODIFIED] = "not_modified",
+        [HTTP_FETCH_UNCHANGED] = "unchanged",
+        [HTTP_FETCH_CHANGED] = "changed",
+    };
+    if (config.revalidate) cJSON_AddStringToObject(response, "revalidation", fetch_status_names[fetch_status]);
+
+    // Raw headers are only serialized when the client asks for them
+    if (cJSON_IsTrue(cJSON_GetObjectItemCaseSensitive(request, "raw_headers"))) {
+        cJSON_AddItemToObject(response, "headers", header_collection_to_json(&headers));
+    }
+
     grading_result_free(&gr);
-    cJSON_Delete(headers_json);
-    free(html);
+    header_collection_free(&headers);
+    http_scan_config_free(&config);
 }
 
 // Process network analysis
@@ -204,7 +258,7 @@ static void handle_client(int client_fd, ReportList *restrict rl) {
 
     cJSON *response = cJSON_CreateObject();
     if (strcmp(analyzer, "http") == 0) {
-        process_http(url, response, rl);
+        process_http(url, request, response, rl);
     } else if (strcmp(analyzer, "network") == 0) {
         process_network(url, response, rl);
     } else {
@@ -224,6 +278,16 @@ int main(void) {
     ReportList rl;
     report_init(&rl);
 
+    // Build the header lookup table and compile the signature automata before serving anything
+    if (http_analyzer_init() != 0) {
+        report_add(&rl, SEV_CRITICAL, "Failed to build HTTP analyzer header table or signatures");
+        report_print_and_free(&rl);
+        return EXIT_FAILURE;
+    }
+
+    // A missing or broken rules file is not fatal: grading falls back to the built-in weights
+    grading_rules_init(NULL);
+
     // Create UDS socket
     int server_fd = socket(AF_UNIX, SOCK_STREAM, 0);
     if (server_fd < 0) {
@@ -271,6 +335,8 @@ int main(void) {
     close(server_fd);
     unlink(SOCKET_PATH);
     na_cleanup_openssl();
+    http_analyzer_cleanup();
+    grading_rules_cleanup();
     report_print_and_free(&rl);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "../../include/scanner/body_inspector.h"
+#include "../../include/scanner/http_headers_analyzer.h"
+#include <string.h>
+
+#define BODY_FINGERPRINT_SEED 1469598103934665603ull
+#define BODY_FINGERPRINT_PRIME 1099511628211ull
+
+void body_inspector_init(BodyInspector* bi, size_t max_size) {
+    memset(bi, 0, sizeof(*bi));
+    bi->max_size = max_size ? max_size : BODY_MAX_SIZE_DEFAULT;
+    if (bi->max_size > BODY_MAX_SIZE_LIMIT) bi->max_size = BODY_MAX_SIZE_LIMIT;
+    bi->first_match = -1;
+    bi->fingerprint_hash = BODY_FINGERPRINT_SEED;
+}
+
+void body_inspector_set_patterns(BodyInspector* bi, const PatternMatcher* matcher, size_t first, size_t count) {
+    bi->matcher = matcher;
+    bi->pattern_first = first;
+    bi->pattern_count = count;
+    bi->match_state = PATTERN_MATCHER_START;
+    bi->matched = 0;
+    bi->first_match = -1;
+}
+
+static int record_match(size_t pattern_id, size_t end_offset, void* ctx) {
+    BodyInspector* bi = ctx;
+    if (pattern_id < bi->pattern_first || pattern_id >= bi->pattern_first + bi->pattern_count) return 0;
+    if (bi->first_match < 0) {
+        bi->first_match = (long)pattern_id;
+        bi->first_match_end = bi->total_size + end_offset;
+    }
+    bi->matched++;
+    return bi->stop_when_decided; // nothing more to learn from this chunk
+}
+
+// Pages that only differ in counters, timestamps or tokens, letter case or layout hash the same
+static void fingerprint_update(BodyInspector* bi, const char* data, size_t len) {
+    uint64_t h = bi->fingerprint_hash;
+    size_t n = bi->fingerprint_len;
+    int gap = bi->fingerprint_gap;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)data[i];
+        if (c >= '0' && c <= '9') continue;
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\f' || c == '\v') { gap = 1; continue; }
+        if (gap && n) {
+            h = (h ^ ' ') * BODY_FINGERPRINT_PRIME;
+            n++;
+        }
+        gap = 0;
+        if (c >= 'A' && c <= 'Z') c |= 0x20;
+        h = (h ^ c) * BODY_FINGERPRINT_PRIME;
+        n++;
+    }
+    bi->fingerprint_hash = h;
+    bi->fingerprint_len = n;
+    bi->fingerprint_gap = gap;
+}
+
+// Returns non-zero once the transfer can be stopped: the size cap was hit or every check is decided
+int body_inspector_feed(BodyInspector* bi, const char* data, size_t len) {
+    if (bi->headers_only) {
+        bi->stopped = 1;
+        return 1;
+    }
+    if (bi->total_size + len > bi->max_size) {
+        len = bi->max_size - bi->total_size;
+        bi->truncated = 1;
+    }
+
+    if (!bi->file_type_detected) {
+        size_t take = BODY_MAGIC_BYTES - bi->magic_len;
+        if (take > len) take = len;
+        memcpy(bi->magic + bi->magic_len, data, take);
+        bi->magic_len += take;
+        if (bi->magic_len == BODY_MAGIC_BYTES) {
+            detect_file_type(bi->magic, bi->magic_len, bi->file_type, sizeof(bi->file_type));
+            bi->file_type_detected = 1;
+        }
+    }
+
+    // The automaton state carries across chunks, so signatures split between them still match
+    if (bi->matcher && bi->pattern_count && !(bi->stop_when_decided && bi->matched)) {
+        bi->match_state = pattern_matcher_scan(bi->matcher, bi->match_state, data, len, record_match, bi);
+    }
+    if (bi->fingerprint && bi->total_size < BODY_FINGERPRINT_PREFIX) {
+        size_t room = BODY_FINGERPRINT_PREFIX - bi->total_size;
+        fingerprint_update(bi, data, len < room ? len : room);
+    }
+    bi->total_size += len;
+
+    if (bi->truncated || (bi->stop_when_decided && body_inspector_decided(bi))) {
+        bi->stopped = 1;
+        return 1;
+    }
+    return 0;
+}
+
+void body_inspector_finish(BodyInspector* bi) {
+    if (!bi->file_type_detected && !bi->headers_only) {
+        detect_file_type(bi->magic, bi->magic_len, bi->file_type, sizeof(bi->file_type));
+        bi->file_type_detected = 1;
+    }
+}
+
+int body_inspector_decided(const BodyInspector* bi) {
+    if (!bi->file_type_detected) return 0;
+    if (bi->fingerprint && bi->total_size < BODY_FINGERPRINT_PREFIX) return 0;
+    return !bi->matcher || bi->pattern_count == 0 || bi->matched != 0;
+}
@@ -0,0 +1,107 @@
+#include "../../include/scanner/cookie_parser.h"
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+
+static int is_cookie_space(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static CookieSpan trim_span(const char* start, const char* end) {
+    while (start < end && is_cookie_space(*start)) start++;
+    while (end > start && is_cookie_space(end[-1])) end--;
+    return (CookieSpan){ start, (size_t)(end - start) };
+}
+
+static int span_equals(CookieSpan s, const char* literal) {
+    size_t len = strlen(literal);
+    return s.len == len && strncasecmp(s.ptr, literal, len) == 0;
+}
+
+static int span_has_prefix(CookieSpan s, const char* prefix) {
+    size_t len = strlen(prefix);
+    return s.len >= len && memcmp(s.ptr, prefix, len) == 0; // cookie prefixes are case-sensitive
+}
+
+// Max-Age per RFC 6265 5.2.2: optional '-', then digits only; anything else ignores the attribute
+static int parse_max_age(CookieSpan s, long* out) {
+    size_t i = 0;
+    int negative = 0;
+    if (s.len && s.ptr[0] == '-') { negative = 1; i = 1; }
+    if (i == s.len) return -1;
+    long v = 0;
+    for (; i < s.len; i++) {
+        if (s.ptr[i] < '0' || s.ptr[i] > '9') return -1;
+        if (v < LONG_MAX / 10) v = v * 10 + (s.ptr[i] - '0');
+    }
+    *out = negative ? -v : v;
+    return 0;
+}
+
+// Positions the cursor just past the name=value pair
+void cookie_attr_iter_init(CookieAttrIter* it, const char* header, size_t len) {
+    const char* semi = memchr(header, ';', len);
+    it->pos = semi ? semi : header + len;
+    it->end = header + len;
+}
+
+int cookie_attr_next(CookieAttrIter* it, CookieSpan* key, CookieSpan* value) {
+    while (it->pos < it->end) {
+        const char* start = it->pos + (*it->pos == ';');
+        const char* semi = memchr(start, ';', (size_t)(it->end - start));
+        const char* stop = semi ? semi : it->end;
+        it->pos = stop;
+        const char* eq = memchr(start, '=', (size_t)(stop - start));
+        *key = trim_span(start, eq ? eq : stop);
+        *value = eq ? trim_span(eq + 1, stop) : (CookieSpan){ stop, 0 };
+        if (key->len) return 1;
+    }
+    return 0;
+}
+
+// Name, value and every attribute in one pass over the header; returns -1 for a header without a name=value pair
+int cookie_parse(const char* header, size_t len, CookieInfo* out) {
+    memset(out, 0, sizeof(*out));
+    if (!header) return -1;
+
+    const char* semi = memchr(header, ';', len);
+    const char* pair_end = semi ? semi : header + len;
+    const char* eq = memchr(header, '=', (size_t)(pair_end - header));
+    if (!eq) return -1;
+    out->name = trim_span(header, eq);
+    out->value = trim_span(eq + 1, pair_end);
+    if (!out->name.len) return -1;
+    if (span_has_prefix(out->name, "__Secure-")) out->flags |= COOKIE_PREFIX_SECURE;
+    if (span_has_prefix(out->name, "__Host-")) out->flags |= COOKIE_PREFIX_HOST;
+
+    CookieAttrIter it;
+    CookieSpan key, value;
+    cookie_attr_iter_init(&it, header, len);
+    while (cookie_attr_next(&it, &key, &value)) {
+        out->attr_count++;
+        if (span_equals(key, "Secure")) {
+            out->flags |= COOKIE_SECURE;
+        } else if (span_equals(key, "HttpOnly")) {
+            out->flags |= COOKIE_HTTPONLY;
+        } else if (span_equals(key, "SameSite")) {
+            // The last occurrence of an attribute wins
+            out->samesite = value;
+            out->flags &= ~(COOKIE_SAMESITE_STRICT | COOKIE_SAMESITE_LAX | COOKIE_SAMESITE_NONE);
+            if (span_equals(value, "Strict")) out->flags |= COOKIE_SAMESITE_STRICT;
+            else if (span_equals(value, "Lax")) out->flags |= COOKIE_SAMESITE_LAX;
+            else if (span_equals(value, "None")) out->flags |= COOKIE_SAMESITE_NONE;
+        } else if (span_equals(key, "Domain")) {
+            if (value.len && value.ptr[0] == '.') { value.ptr++; value.len--; }
+            out->domain = value;
+            if (value.len) out->flags |= COOKIE_HAS_DOMAIN;
+        } else if (span_equals(key, "Path")) {
+            out->path = value;
+            if (value.len && value.ptr[0] == '/') out->flags |= COOKIE_HAS_PATH;
+        } else if (span_equals(key, "Max-Age")) {
+            if (parse_max_age(value, &out->max_age) == 0) out->flags |= COOKIE_HAS_MAX_AGE;
+        } else if (span_equals(key, "Expires")) {
+            if (value.len) out->flags |= COOKIE_HAS_EXPIRES;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "../../include/scanner/csp.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+static const char* const directive_names[CSP_DIR_KNOWN_COUNT] = {
+    [CSP_DIR_DEFAULT_SRC] = "default-src",
+    [CSP_DIR_SCRIPT_SRC] = "script-src",
+    [CSP_DIR_OBJECT_SRC] = "object-src",
+    [CSP_DIR_BASE_URI] = "base-uri",
+};
+
+static const struct {
+    const char* token;
+    unsigned kind;
+} keyword_sources[] = {
+    { "'none'", CSP_SRC_NONE },
+    { "'self'", CSP_SRC_SELF },
+    { "'unsafe-inline'", CSP_SRC_UNSAFE_INLINE },
+    { "'unsafe-eval'", CSP_SRC_UNSAFE_EVAL },
+    { "'strict-dynamic'", CSP_SRC_STRICT_DYNAMIC },
+    { "'unsafe-hashes'", CSP_SRC_UNSAFE_HASHES },
+    { "*", CSP_SRC_WILDCARD },
+    { "http:", CSP_SRC_SCHEME_HTTP },
+    { "https:", CSP_SRC_SCHEME_HTTP },
+    { "data:", CSP_SRC_SCHEME_DATA },
+};
+
+static int is_csp_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+static int has_prefix(const char* s, size_t len, const char* prefix) {
+    size_t plen = strlen(prefix);
+    return len > plen && strncasecmp(s, prefix, plen) == 0;
+}
+
+static unsigned classify_source(const char* s, size_t len) {
+    for (size_t i = 0; i < sizeof(keyword_sources) / sizeof(keyword_sources[0]); i++) {
+        const char* token = keyword_sources[i].token;
+        if (strlen(token) == len && strncasecmp(s, token, len) == 0) return keyword_sources[i].kind;
+    }
+    if (has_prefix(s, len, "'nonce-")) return CSP_SRC_NONCE;
+    if (has_prefix(s, len, "'sha256-") || has_prefix(s, len, "'sha384-") || has_prefix(s, len, "'sha512-")) return CSP_SRC_HASH;
+    if (s[0] == '\'') return 0; // other keywords such as 'report-sample' do not widen the policy
+    if (s[len - 1] == ':' && !memchr(s, '/', len)) return CSP_SRC_SCHEME_OTHER;
+    return CSP_SRC_HOST;
+}
+
+static CspDirectiveId classify_directive(const char* s, size_t len) {
+    for (int id = 0; id < CSP_DIR_KNOWN_COUNT; id++) {
+        if (strlen(directive_names[id]) == len && strncasecmp(s, directive_names[id], len) == 0) return (CspDirectiveId)id;
+    }
+    return CSP_DIR_OTHER;
+}
+
+// A policy has at most one directive per ';' and at most one source per pair of bytes, so sizing up front is exact enough
+int csp_parse(const char* value, size_t len, CspPolicy* policy) {
+    if (!value || !policy) return -1;
+    memset(policy, 0, sizeof(*policy));
+
+    size_t max_directives = 1, max_policies = 1, max_sources = len / 2 + 1;
+    for (size_t i = 0; i < len; i++) {
+        if (value[i] == ';' || value[i] == ',') max_directives++;
+        if (value[i] == ',') max_policies++;
+    }
+    policy->text = malloc(len + 1);
+    policy->directives = malloc(max_directives * sizeof(*policy->directives));
+    policy->sources = malloc(max_sources * sizeof(*policy->sources));
+    policy->by_id = calloc(max_policies, sizeof(*policy->by_id));
+    if (!policy->text || !policy->directives || !policy->sources || !policy->by_id) {
+        fprintf(stderr, "Memory allocation failed\n");
+        csp_policy_free(policy);
+        return -1;
+    }
+    memcpy(policy->text, value, len);
+    policy->text[len] = 0;
+    policy->text_len = len;
+
+    const char* text = policy->text;
+    size_t pos = 0, current = 0;
+    int current_empty = 1, split = 0;
+    while (pos < len) {
+        size_t end = pos;
+        while (end < len && text[end] != ';' && text[end] != ',') end++;
+
+        size_t p = pos;
+        while (p < end && is_csp_space(text[p])) p++;
+        size_t name_start = p;
+        while (p < end && !is_csp_space(text[p])) p++;
+        size_t name_len = p - name_start;
+
+        if (name_len > 0) {
+            // Empty policies around stray commas restrict nothing and are dropped
+            if (split) {
+                current++;
+                split = 0;
+            }
+            current_empty = 0;
+            CspDirectiveId id = classify_directive(text + name_start, name_len);
+            // Per spec only the first occurrence of a directive in a policy counts
+            if (id == CSP_DIR_OTHER || !policy->by_id[current][id]) {
+                CspDirective* dir = &policy->directives[policy->directive_count++];
+                dir->name_off = (uint32_t)name_start;
+                dir->name_len = (uint32_t)name_len;
+                dir->id = id;
+                dir->first_source = (uint32_t)policy->source_count;
+                dir->source_count = 0;
+                dir->flags = 0;
+
+                while (p < end) {
+                    while (p < end && is_csp_space(text[p])) p++;
+                    size_t src_start = p;
+                    while (p < end && !is_csp_space(text[p])) p++;
+                    if (p == src_start) break;
+                    CspSource* src = &policy->sources[policy->source_count++];
+                    src->off = (uint32_t)src_start;
+                    src->len = (uint32_t)(p - src_start);
+                    src->kind = classify_source(text + src_start, p - src_start);
+                    dir->flags |= src->kind;
+                    dir->source_count++;
+                }
+                if (id != CSP_DIR_OTHER) policy->by_id[current][id] = (int)policy->directive_count;
+            }
+        }
+        if (end < len && text[end] == ',' && !current_empty) {
+            split = 1;
+            current_empty = 1;
+        }
+        pos = end + 1;
+    }
+    policy->policy_count = current + 1;
+    return 0;
+}
+
+void csp_policy_free(CspPolicy* policy) {
+    if (!policy) return;
+    free(policy->text);
+    free(policy->directives);
+    free(policy->sources);
+    free(policy->by_id);
+    memset(policy, 0, sizeof(*policy));
+}
+
+const CspDirective* csp_find_directive(const CspPolicy* policy, size_t index, CspDirectiveId id) {
+    if (index >= policy->policy_count || id >= CSP_DIR_KNOWN_COUNT || !policy->by_id[index][id]) return NULL;
+    return &policy->directives[policy->by_id[index][id] - 1];
+}
+
+const char* csp_directive_name(CspDirectiveId id) {
+    return id < CSP_DIR_KNOWN_COUNT ? directive_names[id] : "";
+}
+
+// Fetch directives without their own entry fall back to default-src
+static const CspDirective* effective_directive(const CspPolicy* policy, size_t index, CspDirectiveId id, CspDirectiveId* from) {
+    const CspDirective* dir = csp_find_directive(policy, index, id);
+    *from = id;
+    if (!dir) {
+        dir = csp_find_directive(policy, index, CSP_DIR_DEFAULT_SRC);
+        *from = dir ? CSP_DIR_DEFAULT_SRC : CSP_DIR_OTHER;
+    }
+    return dir;
+}
+
+static void evaluate_policy(const CspPolicy* policy, size_t index, CspEvaluation* out) {
+    memset(out, 0, sizeof(*out));
+
+    const CspDirective* def = csp_find_directive(policy, index, CSP_DIR_DEFAULT_SRC);
+    if (!def) out->issues |= CSP_ISSUE_NO_DEFAULT_SRC;
+    else if (def->flags & (CSP_SRC_WILDCARD | CSP_SRC_UNSAFE_INLINE | CSP_SRC_SCHEME_DATA)) out->issues |= CSP_ISSUE_DEFAULT_SRC_RISKY;
+
+    const CspDirective* script = effective_directive(policy, index, CSP_DIR_SCRIPT_SRC, &out->script_from);
+    if (!script) {
+        out->issues |= CSP_ISSUE_SCRIPT_UNRESTRICTED;
+    } else {
+        unsigned flags = script->flags;
+        const unsigned allowlist = CSP_SRC_SELF | CSP_SRC_HOST | CSP_SRC_WILDCARD | CSP_SRC_SCHEME_HTTP |
+                                   CSP_SRC_SCHEME_DATA | CSP_SRC_SCHEME_OTHER | CSP_SRC_UNSAFE_INLINE;
+        // 'strict-dynamic' makes browsers ignore allowlists and 'unsafe-inline'; a nonce or hash alone drops 'unsafe-inline'
+        if (flags & CSP_SRC_STRICT_DYNAMIC) {
+            flags &= ~allowlist;
+            if (!(flags & (CSP_SRC_NONCE | CSP_SRC_HASH))) out->issues |= CSP_ISSUE_STRICT_DYNAMIC_ALONE;
+        } else if (flags & (CSP_SRC_NONCE | CSP_SRC_HASH)) {
+            flags &= ~CSP_SRC_UNSAFE_INLINE;
+        }
+        out->script = flags;
+        if (flags & CSP_SRC_UNSAFE_INLINE) out->issues |= CSP_ISSUE_SCRIPT_UNSAFE_INLINE;
+        if (flags & CSP_SRC_UNSAFE_EVAL) out->issues |= CSP_ISSUE_SCRIPT_UNSAFE_EVAL;
+        if (flags & (CSP_SRC_WILDCARD | CSP_SRC_SCHEME_HTTP)) out->issues |= CSP_ISSUE_SCRIPT_ANY_HOST;
+        if (flags & CSP_SRC_SCHEME_DATA) out->issues |= CSP_ISSUE_SCRIPT_DATA;
+    }
+
+    const CspDirective* object = effective_directive(policy, index, CSP_DIR_OBJECT_SRC, &out->object_from);
+    out->object = object ? object->flags : 0;
+    if (out->object != CSP_SRC_NONE) out->issues |= CSP_ISSUE_OBJECT_NOT_NONE;
+
+    const CspDirective* base = csp_find_directive(policy, index, CSP_DIR_BASE_URI);
+    out->has_base_uri = base != NULL;
+    out->base_uri = base ? base->flags : 0;
+    if (!base) out->issues |= CSP_ISSUE_BASE_URI_MISSING;
+}
+
+// A resource must pass every enforced policy, so a weakness survives only if no policy closes it. Source
+// kinds are intersected as kinds, which overstates what two different host lists allow together.
+static void intersect_evaluation(CspEvaluation* acc, const CspEvaluation* next) {
+    if (acc->issues & CSP_ISSUE_SCRIPT_UNRESTRICTED) {
+        acc->script = next->script;
+        acc->script_from = next->script_from;
+    } else if (!(next->issues & CSP_ISSUE_SCRIPT_UNRESTRICTED)) {
+        acc->script &= next->script;
+    }
+    if (acc->object_from == CSP_DIR_OTHER) {
+        acc->object = next->object;
+        acc->object_from = next->object_from;
+    } else if (next->object_from != CSP_DIR_OTHER) {
+        acc->object &= next->object;
+    }
+    if (!acc->has_base_uri) {
+        acc->base_uri = next->base_uri;
+        acc->has_base_uri = next->has_base_uri;
+    }
+    // One policy with a bare 'strict-dynamic' is enough to block every script
+    const unsigned any = CSP_ISSUE_STRICT_DYNAMIC_ALONE;
+    acc->issues = (acc->issues & next->issues) | ((acc->issues | next->issues) & any);
+}
+
+void csp_evaluate(const CspPolicy* policy, CspEvaluation* out) {
+    evaluate_policy(policy, 0, out);
+    for (size_t i = 1; i < policy->policy_count; i++) {
+        CspEvaluation next;
+        evaluate_policy(policy, i, &next);
+        intersect_evaluation(out, &next);
+    }
+}
+
+typedef struct {
+    uint64_t hash;
+    int used;
+    CspPolicy policy;
+    CspEvaluation evaluation;
+} CspCacheSlot;
+
+static CspCacheSlot csp_cache[CSP_CACHE_SLOTS];
+static pthread_mutex_t csp_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t hash_value(const char* value, size_t len) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)value[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Direct-mapped cache: many endpoints share one policy string, so a hit skips both parse and evaluation
+int csp_evaluate_cached(const char* value, CspEvaluation* out) {
+    if (!value || !out) return -1;
+    size_t len = strlen(value);
+    uint64_t hash = hash_value(value, len);
+    CspCacheSlot* slot = &csp_cache[hash % CSP_CACHE_SLOTS];
+
+    pthread_mutex_lock(&csp_cache_lock);
+    if (slot->used && slot->hash == hash && slot->policy.text_len == len && memcmp(slot->policy.text, value, len) == 0) {
+        *out = slot->evaluation;
+        pthread_mutex_unlock(&csp_cache_lock);
+        return 0;
+    }
+    pthread_mutex_unlock(&csp_cache_lock);
+
+    CspPolicy policy;
+    if (csp_parse(value, len, &policy) != 0) return -1;
+    csp_evaluate(&policy, out);
+
+    pthread_mutex_lock(&csp_cache_lock);
+    if (slot->used) csp_policy_free(&slot->policy);
+    slot->hash = hash;
+    slot->used = 1;
+    slot->policy = policy;
+    slot->evaluation = *out;
+    pthread_mutex_unlock(&csp_cache_lock);
+    return 0;
+}
+
+void csp_cache_clear(void) {
+    pthread_mutex_lock(&csp_cache_lock);
+    for (size_t i = 0; i < CSP_CACHE_SLOTS; i++) {
+        if (csp_cache[i].used) csp_policy_free(&csp_cache[i].policy);
+        csp_cache[i].used = 0;
+    }
+    pthread_mutex_unlock(&csp_cache_lock);
+}
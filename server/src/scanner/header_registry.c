@@ -0,0 +1,66 @@
+#include "../../include/scanner/header_registry.h"
+#include <assert.h>
+#include <string.h>
+
+#define HEADER_NAME_ENTRY(id, name) [HDR_##id] = name,
+#define HEADER_SEED_ATTEMPTS 4096
+
+static const char* const header_names[HDR_COUNT] = {
+    [HDR_UNKNOWN] = "",
+    HEADER_LIST(HEADER_NAME_ENTRY)
+};
+
+_Static_assert(HDR_COUNT <= HEADER_HASH_SLOTS, "HEADER_HASH_SLOTS must exceed the number of known headers");
+
+static uint32_t hash_seed;
+static unsigned char slots[HEADER_HASH_SLOTS]; // slot -> HeaderId, HDR_UNKNOWN when empty
+static int registry_ready;
+
+static uint32_t fnv1a(const char* name, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Pick the first seed under which every known name lands in its own slot, making lookups a single probe
+int header_registry_init(void) {
+    if (registry_ready) return 0;
+    for (uint32_t seed = 0; seed < HEADER_SEED_ATTEMPTS; seed++) {
+        memset(slots, 0, sizeof(slots));
+        int collision = 0;
+        for (int id = 1; id < HDR_COUNT && !collision; id++) {
+            uint32_t slot = fnv1a(header_names[id], strlen(header_names[id]), seed) & (HEADER_HASH_SLOTS - 1);
+            if (slots[slot]) collision = 1;
+            else slots[slot] = (unsigned char)id;
+        }
+        if (!collision) {
+            hash_seed = seed;
+            registry_ready = 1;
+            return 0;
+        }
+    }
+    memset(slots, 0, sizeof(slots));
+    return -1;
+}
+
+// Expects an already lower-cased name
+uint32_t header_name_hash(const char* name, size_t len) {
+    // Hashing before a successful init would make every known header look unknown
+    assert(registry_ready && "header_registry_init() must succeed before headers are hashed");
+    return fnv1a(name, len, hash_seed);
+}
+
+HeaderId header_lookup(const char* name, size_t len, uint32_t hash) {
+    HeaderId id = slots[hash & (HEADER_HASH_SLOTS - 1)];
+    if (id == HDR_UNKNOWN) return HDR_UNKNOWN;
+    const char* known = header_names[id];
+    if (strncmp(known, name, len) != 0 || known[len] != 0) return HDR_UNKNOWN;
+    return id;
+}
+
+const char* header_name(HeaderId id) {
+    return (id > HDR_UNKNOWN && id < HDR_COUNT) ? header_names[id] : "";
+}
@@ -1,4 +1,12 @@
 #include "../../include/scanner/http_headers_analyzer.h"
+#include "../../include/helpers/grading.h"
+#include "../../include/scanner/cookie_parser.h"
+#include "../../include/scanner/csp.h"
+#include "../../include/scanner/http_probe.h"
+#include "../../include/scanner/injection_engine.h"
+#include "../../include/scanner/rate_limit.h"
+#include "../../include/scanner/simd_search.h"
+#include "../../include/scanner/validator_cache.h"
 #include <cjson/cJSON.h>
 #include <ctype.h>
 #include <stdarg.h>
@@ -7,128 +15,141 @@
 #include <string.h>
 #include <strings.h>
 #include <curl/curl.h>
-#include <regex.h>
+#include <pthread.h>
 #include <time.h>
-#include <unistd.h>
 
-#define MAX_REQUESTS 10
-#define REQUEST_INTERVAL_MS 100
-#define MAX_PAYLOADS 3
-#define COOKIE_MAX_ATTRS 10
+#define HTTP_FETCH_TIMEOUT_S 30L
 
-typedef struct {
-    char* data;
-    size_t size;
-} MemoryStruct;
+// Order of the file types matches what detect_file_type() reports
+enum { CT_CHARSET_UTF8, CT_FIRST_FILE_TYPE, CT_PATTERN_COUNT = CT_FIRST_FILE_TYPE + 5 };
+static const char* const content_type_patterns[CT_PATTERN_COUNT] = {
+    "charset=utf-8", "image/png", "image/jpeg", "application/pdf", "application/x-executable", "text/html"
+};
 
-typedef struct {
-    char key[64];
-    char value[256];
-} CookieAttribute;
+static PatternMatcher content_type_matcher;
+static int matchers_ready;
+static pthread_once_t matchers_once = PTHREAD_ONCE_INIT;
 
-typedef struct {
-    char* name;
-    CookieAttribute attrs[COOKIE_MAX_ATTRS];
-    int attr_count;
-} Cookie;
+static void build_matchers(void) {
+    matchers_ready =
+        header_registry_init() == 0 &&
+        injection_corpus_init(NULL) == 0 &&
+        pattern_matcher_build(&content_type_matcher, content_type_patterns, CT_PATTERN_COUNT) == 0;
+}
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    size_t total_size = size * nmemb;
-    MemoryStruct* mem = userp;
+// Compiles every signature set once; analyzers also call this lazily, so calling it at startup only moves the cost
+int http_analyzer_init(void) {
+    pthread_once(&matchers_once, build_matchers);
+    return matchers_ready ? 0 : -1;
+}
 
-    char* ptr = realloc(mem->data, mem->size + total_size + 1);
-    if (!ptr) {
-        fprintf(stderr, "Failed to allocate memory for response body\n");
-        return 0;
-    }
+void http_analyzer_cleanup(void) {
+    injection_corpus_cleanup();
+    csp_cache_clear();
+    validator_cache_clear();
+    pattern_matcher_free(&content_type_matcher);
+    matchers_ready = 0;
+}
 
-    mem->data = ptr;
-    memcpy(&(mem->data[mem->size]), contents, total_size);
-    mem->size += total_size;
-    mem->data[mem->size] = 0;
+const char* http_body_check_name(unsigned check) {
+    switch (check) {
+        case HTTP_CHECK_CONTENT_SNIFF: return "content_sniff";
+        case HTTP_CHECK_INJECTION: return "injection";
+        default: return "unknown";
+    }
+}
 
-    return total_size;
+int http_scan_config_enable_http2(HttpScanConfig* config) {
+    if (!config) return -1;
+    if (!config->share) config->share = probe_share_init();
+    if (!config->share) { fprintf(stderr, "Failed to init curl share handle\n"); return -1; }
+    config->http2 = 1;
+    return 0;
 }
 
-static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
-    size_t total_size = nitems * size;
-    cJSON* headers_json = (cJSON*)userdata;
+// Only call once every batch created with this config has been freed
+void http_scan_config_free(HttpScanConfig* config) {
+    if (!config) return;
+    probe_share_free(config->share);
+    config->share = NULL;
+    config->http2 = 0;
+}
 
-    char* colon_pos = memchr(buffer, ':', total_size);
-    if (!colon_pos) return total_size;
+static int scan_batch_init(ProbeBatch* pb, long max_per_origin, const HttpScanConfig* config) {
+    if (probe_batch_init(pb, max_per_origin, config->max_body_size) != 0) return -1;
+    if (config->http2) probe_batch_enable_http2(pb, config->share);
+    return 0;
+}
 
-    size_t name_len = colon_pos - buffer;
-    while (name_len > 0 && (buffer[name_len - 1] == ' ' || buffer[name_len - 1] == '\t')) name_len--;
+static int same_validator(const char* stored, const HeaderCollection* hc, const char* name) {
+    int idx = find_header(hc, name);
+    return stored[0] && idx >= 0 && strcmp(stored, header_value_at(hc, idx)) == 0;
+}
 
-    char* name = malloc(name_len + 1);
-    if (!name) return 0;
-    memcpy(name, buffer, name_len);
-    name[name_len] = 0;
+// A full response matches the earlier one when it carries the same validator, or when the bytes the
+// inspector read (and so every body finding) hash the same; a header-only scan has no digest to compare
+static int same_as_cached(const ValidatorEntry* cached, const HeaderCollection* hc, const HttpProbe* probe) {
+    if (same_validator(cached->etag, hc, "etag") || same_validator(cached->last_modified, hc, "last-modified")) return 1;
+    return probe->has_digest && cached->has_digest && probe->body.total_size == cached->body.total_size &&
+           memcmp(probe->body_digest, cached->digest, PROBE_DIGEST_SIZE) == 0;
+}
 
-    char* value_start = colon_pos + 1;
-    size_t value_len = total_size - (value_start - buffer);
-    while (value_len > 0 && (value_start[value_len - 1] == '\r' || value_start[value_len - 1] == '\n' || value_start[value_len - 1] == ' ' || value_start[value_len - 1] == '\t')) value_len--;
-    while (value_len > 0 && (*value_start == ' ' || *value_start == '\t')) { value_start++; value_len--; }
+// Returns an HttpFetchStatus, or -1 when the page could not be fetched
+int http_fetch_url(const char* url, const HttpScanConfig* config, HeaderCollection* out_headers, BodyInspector* out_body) {
+    if (!url || !config || !out_headers || !out_body) return -1;
 
-    char* value = malloc(value_len + 1);
-    if (!value) { free(name); return 0; }
-    memcpy(value, value_start, value_len);
-    value[value_len] = 0;
+    const int sniff = (config->body_checks & HTTP_CHECK_CONTENT_SNIFF) != 0;
+    ValidatorEntry cached;
+    int have_cached = config->revalidate && validator_cache_lookup(url, &cached);
+    // A header-only scan left nothing to reuse for a sniffing one
+    if (have_cached && sniff && cached.body.headers_only) {
+        validator_entry_free(&cached);
+        have_cached = 0;
+    }
 
-    cJSON* header_obj = cJSON_CreateObject();
-    cJSON_AddStringToObject(header_obj, "name", name);
-    cJSON_AddStringToObject(header_obj, "value", value);
-    cJSON_AddItemToArray(headers_json, header_obj);
-
-    free(name);
-    free(value);
-    return total_size;
-}
-
-int http_fetch_url(const char* url, cJSON** out_headers, char** out_html) {
-    if (!url || !out_headers || !out_html) return -1;
-
-    CURL* curl = curl_easy_init();
-    if (!curl) { fprintf(stderr, "Failed to init curl\n"); return -1; }
-
-    MemoryStruct chunk = {0};
-    cJSON* headers_json = cJSON_CreateArray();
-    if (!headers_json) { fprintf(stderr, "Failed to allocate JSON array\n"); curl_easy_cleanup(curl); return -1; }
-
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &chunk);
-    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, headers_json);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (compatible; APIMonitor/1.0)");
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-
-    CURLcode res = curl_easy_perform(curl);
-    if (res != CURLE_OK) {
-        fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
-        cJSON_Delete(headers_json);
-        free(chunk.data);
-        curl_easy_cleanup(curl);
+    ProbeBatch pb;
+    if (scan_batch_init(&pb, 1, config) != 0) {
+        if (have_cached) validator_entry_free(&cached);
         return -1;
     }
 
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    if (http_code < 200 || http_code >= 300) {
-        fprintf(stderr, "HTTP request failed with code %ld\n", http_code);
-        cJSON_Delete(headers_json);
-        free(chunk.data);
-        curl_easy_cleanup(curl);
+    HttpProbe* probe = probe_batch_add(&pb, url, HTTP_FETCH_TIMEOUT_S);
+    if (!probe) {
+        fprintf(stderr, "Failed to init curl\n");
+        probe_batch_free(&pb);
+        if (have_cached) validator_entry_free(&cached);
         return -1;
     }
+    // Only the magic bytes are needed from the page itself, and nothing at all without sniffing
+    probe->body.stop_when_decided = 1;
+    probe->body.headers_only = !sniff;
+    if (config->revalidate && sniff) probe_track_digest(probe);
+    if (have_cached && time(NULL) - cached.stored_at <= VALIDATOR_MAX_AGE_S) probe_set_validators(probe, cached.etag, cached.last_modified);
+    probe_batch_wait(&pb);
+
+    int status = -1;
+    if (!probe->done || probe->result != CURLE_OK) {
+        fprintf(stderr, "HTTP fetch failed: %s\n", curl_easy_strerror(probe->done ? probe->result : CURLE_OPERATION_TIMEDOUT));
+    } else if (probe->http_code == 304 && have_cached) {
+        memset(out_headers, 0, sizeof(*out_headers));
+        validator_cache_merge_304(&cached, &probe->headers, out_headers);
+        validator_cache_refresh(url, &cached, out_headers);
+        *out_body = cached.body;
+        status = HTTP_FETCH_NOT_MODIFIED;
+    } else if (probe->http_code < 200 || probe->http_code >= 300) {
+        fprintf(stderr, "HTTP request failed with code %ld\n", probe->http_code);
+    } else {
+        if (config->revalidate) validator_cache_store(url, &probe->headers, &probe->body, probe->has_digest ? probe->body_digest : NULL);
+        if (!have_cached) status = HTTP_FETCH_NEW;
+        else status = same_as_cached(&cached, &probe->headers, probe) ? HTTP_FETCH_UNCHANGED : HTTP_FETCH_CHANGED;
+        *out_headers = probe->headers;
+        *out_body = probe->body;
+        memset(&probe->headers, 0, sizeof(probe->headers));
+    }
 
-    curl_easy_cleanup(curl);
-    *out_headers = headers_json;
-    *out_html = chunk.data;
-    return 0;
+    probe_batch_free(&pb);
+    if (have_cached) validator_entry_free(&cached);
+    return status;
 }
 
 void normalize_name(char* dst, const char* src) {
@@ -151,50 +172,166 @@ void trim_whitespace(char** str_ptr) {
     *str_ptr = str;
 }
 
-int find_header(HeaderCollection* hc, const char* name) {
-    for (int i = 0; i < hc->count; i++) {
-        if (strcmp(hc->headers[i].name, name) == 0) return i;
+int find_header_id(const HeaderCollection* hc, HeaderId id) {
+    if (id <= HDR_UNKNOWN || id >= HDR_COUNT) return -1;
+    return hc->by_id[id] - 1;
+}
+
+// Known names resolve through the perfect hash, unknown ones through the collection's own name table
+static int find_header_hashed(const HeaderCollection* hc, const char* name, uint32_t hash, HeaderId id) {
+    if (id != HDR_UNKNOWN) return find_header_id(hc, id);
+    if (!hc->names_cap) return -1;
+    unsigned mask = (unsigned)hc->names_cap - 1;
+    for (unsigned slot = hash & mask;; slot = (slot + 1) & mask) {
+        int i = hc->names[slot] - 1;
+        if (i < 0) return -1;
+        if (hc->headers[i].hash == hash && strcmp(header_name_at(hc, i), name) == 0) return i;
     }
-    return -1;
 }
 
-void add_header(HeaderCollection* hc, const char* name_raw, const char* value_raw) {
-    if (hc->count >= MAX_HEADERS) { fprintf(stderr, "Header limit reached\n"); return; }
+int find_header(const HeaderCollection* hc, const char* name) {
+    size_t len = strlen(name);
+    uint32_t hash = header_name_hash(name, len);
+    return find_header_hashed(hc, name, hash, header_lookup(name, len, hash));
+}
 
-    char name[MAX_HEADER_NAME];
-    strncpy(name, name_raw, sizeof(name) - 1);
-    name[sizeof(name) - 1] = 0;
-    normalize_name(name, name);
+void header_collection_reset(HeaderCollection* hc) {
+    hc->count = 0;
+    hc->pool_len = 0;
+    memset(hc->by_id, 0, sizeof(hc->by_id));
+    if (hc->names) memset(hc->names, 0, hc->names_cap * sizeof(*hc->names));
+    hc->names_used = 0;
+}
 
-    char value[MAX_HEADER_VALUE];
-    strncpy(value, value_raw, sizeof(value) - 1);
-    value[sizeof(value) - 1] = 0;
-    char* value_ptr = value;
-    trim_whitespace(&value_ptr);
+void header_collection_free(HeaderCollection* hc) {
+    if (!hc) return;
+    free(hc->pool);
+    free(hc->headers);
+    free(hc->names);
+    memset(hc, 0, sizeof(*hc));
+}
 
-    int idx = find_header(hc, name);
-    if (idx >= 0) {
-        hc->headers[idx].duplicates++;
-    } else {
-        strncpy(hc->headers[hc->count].name, name, MAX_HEADER_NAME - 1);
-        hc->headers[hc->count].name[MAX_HEADER_NAME - 1] = 0;
-        strncpy(hc->headers[hc->count].value, value_ptr, MAX_HEADER_VALUE - 1);
-        hc->headers[hc->count].value[MAX_HEADER_VALUE - 1] = 0;
-        hc->headers[hc->count].duplicates = 0;
-        hc->count++;
+static int header_collection_reserve(HeaderCollection* hc, size_t bytes) {
+    if (hc->count == hc->capacity) {
+        int new_capacity = hc->capacity ? hc->capacity * 2 : 32;
+        HttpHeader* ptr = realloc(hc->headers, new_capacity * sizeof(*ptr));
+        if (!ptr) return -1;
+        hc->headers = ptr;
+        hc->capacity = new_capacity;
+    }
+    if (hc->pool_len + bytes > hc->pool_cap) {
+        size_t new_cap = hc->pool_cap ? hc->pool_cap : 2048;
+        while (new_cap < hc->pool_len + bytes) new_cap *= 2;
+        char* ptr = realloc(hc->pool, new_cap);
+        if (!ptr) return -1;
+        hc->pool = ptr;
+        hc->pool_cap = new_cap;
+    }
+    return 0;
+}
+
+static void name_table_insert(int* names, int cap, uint32_t hash, int entry) {
+    unsigned mask = (unsigned)cap - 1;
+    unsigned slot = hash & mask;
+    while (names[slot]) slot = (slot + 1) & mask;
+    names[slot] = entry;
+}
+
+// Keeps the unknown-name table at most half full so probes stay short
+static int name_table_reserve(HeaderCollection* hc) {
+    if ((hc->names_used + 1) * 2 <= hc->names_cap) return 0;
+    int new_cap = hc->names_cap ? hc->names_cap * 2 : 64;
+    int* names = calloc(new_cap, sizeof(*names));
+    if (!names) return -1;
+    for (int slot = 0; slot < hc->names_cap; slot++) {
+        int entry = hc->names[slot];
+        if (entry) name_table_insert(names, new_cap, hc->headers[entry - 1].hash, entry);
+    }
+    free(hc->names);
+    hc->names = names;
+    hc->names_cap = new_cap;
+    return 0;
+}
+
+// Length-delimited variant so callers holding a raw header line need not copy or terminate it
+void add_header_n(HeaderCollection* hc, const char* name_raw, size_t name_len, const char* value_raw, size_t value_len) {
+    while (value_len > 0 && isspace((unsigned char)*value_raw)) { value_raw++; value_len--; }
+    while (value_len > 0 && isspace((unsigned char)value_raw[value_len - 1])) value_len--;
+
+    size_t bytes = name_len + 1 + value_len + 1;
+    if (hc->pool_len + bytes > HEADER_POOL_LIMIT) { fprintf(stderr, "Header pool limit reached\n"); return; }
+    if (header_collection_reserve(hc, bytes) != 0) { fprintf(stderr, "Memory allocation failed\n"); return; }
+
+    char* name = hc->pool + hc->pool_len;
+    for (size_t i = 0; i < name_len; i++) name[i] = tolower((unsigned char)name_raw[i]);
+    name[name_len] = 0;
+    char* value = name + name_len + 1;
+    memcpy(value, value_raw, value_len);
+    value[value_len] = 0;
+
+    uint32_t hash = header_name_hash(name, name_len);
+    HeaderId id = header_lookup(name, name_len, hash);
+    int first = find_header_hashed(hc, name, hash, id);
+    if (first < 0 && id == HDR_UNKNOWN && name_table_reserve(hc) != 0) { fprintf(stderr, "Memory allocation failed\n"); return; }
+
+    HttpHeader* hdr = &hc->headers[hc->count];
+    hdr->name_off = (uint32_t)hc->pool_len;
+    hdr->name_len = (uint32_t)name_len;
+    hdr->value_off = (uint32_t)(hc->pool_len + name_len + 1);
+    hdr->value_len = (uint32_t)value_len;
+    hdr->hash = hash;
+    hdr->id = id;
+    hdr->next = 0;
+    hdr->duplicates = 0;
+    hc->pool_len += bytes;
+    hc->count++;
+
+    if (first < 0) {
+        hdr->first = hdr->last = hc->count;
+        if (id != HDR_UNKNOWN) {
+            hc->by_id[id] = hc->count;
+        } else {
+            name_table_insert(hc->names, hc->names_cap, hash, hc->count);
+            hc->names_used++;
+        }
+        return;
     }
+    HttpHeader* head = &hc->headers[first];
+    hdr->first = first + 1;
+    hdr->last = 0;
+    head->duplicates++;
+    hc->headers[head->last - 1].next = hc->count;
+    head->last = hc->count;
+}
+
+void add_header(HeaderCollection* hc, const char* name_raw, const char* value_raw) {
+    add_header_n(hc, name_raw, strlen(name_raw), value_raw, strlen(value_raw));
+}
+
+cJSON* header_collection_to_json(const HeaderCollection* hc) {
+    cJSON* array = cJSON_CreateArray();
+    if (!array) return NULL;
+    for (int i = 0; i < hc->count; i++) {
+        cJSON* header_obj = cJSON_CreateObject();
+        cJSON_AddStringToObject(header_obj, "name", header_name_at(hc, i));
+        cJSON_AddStringToObject(header_obj, "value", header_value_at(hc, i));
+        cJSON_AddItemToArray(array, header_obj);
+    }
+    return array;
 }
 
 void parse_raw_headers(const char* raw_headers, HeaderCollection* hc) {
     if (!raw_headers || !hc) return;
-    hc->count = 0;
+    header_collection_reset(hc);
     char* copy = strdup(raw_headers);
     if (!copy) { fprintf(stderr, "Memory allocation failed\n"); return; }
 
     char* line_start = copy;
     while (*line_start) {
-        char* line_end = strstr(line_start, "\r\n");
-        if (!line_end) line_end = strchr(line_start, '\n');
+        // Lines may end in CRLF or a bare LF, mixed within one block
+        char* line_end = strchr(line_start, '\n');
+        char* next = line_end ? line_end + 1 : NULL;
+        if (line_end && line_end > line_start && line_end[-1] == '\r') line_end--;
         if (line_end) *line_end = 0;
 
         char* colon = strchr(line_start, ':');
@@ -203,7 +340,7 @@ void parse_raw_headers(const char* raw_headers, HeaderCollection* hc) {
             add_header(hc, line_start, colon + 1);
         }
         if (!line_end) break;
-        line_start = line_end + ((line_end[0] == '\r' && line_end[1] == '\n') ? 2 : 1);
+        line_start = next;
     }
     free(copy);
 }
@@ -220,311 +357,226 @@ void detect_file_type(const char* data, size_t size, char* file_type, size_t fil
         strncpy(file_type, "image/jpeg", file_type_len);
     } else if (size >= 4 && memcmp(data, "%PDF", 4) == 0) {
         strncpy(file_type, "application/pdf", file_type_len);
-    } else if (size >= 4 && memcmp(data, "\x7FELF", 4) == 0) {
+    } else if (size >= 4 && memcmp(data, "\x7F" "ELF", 4) == 0) {
         strncpy(file_type, "application/x-executable", file_type_len);
     } else {
         strncpy(file_type, "text/html", file_type_len); // Default assumption
     }
 }
 
-void analyze_content_type(const char* value, const char* body, size_t body_size, ReportList* rl) {
+void analyze_content_type(const char* value, const char* file_type, ReportList* rl) {
     if (!value) {
         report_add(rl, SEV_WARNING, "Content-Type header missing.");
         return;
     }
-    char file_type[64];
-    detect_file_type(body, body_size, file_type, sizeof(file_type));
-    if (strcasestr_exists(value, "charset=utf-8")) {
+    http_analyzer_init();
+    unsigned char hits[CT_PATTERN_COUNT] = {0};
+    pattern_matcher_mark(&content_type_matcher, value, strlen(value), hits);
+
+    if (hits[CT_CHARSET_UTF8]) {
         report_add(rl, SEV_INFO, "Content-Type charset set to UTF-8.");
     } else {
         report_add(rl, SEV_WARNING, "Non-UTF-8 charset detected or charset missing in Content-Type.");
     }
-    if (!strcasestr_exists(value, file_type)) {
+    // Without a sniffed body only the header itself can be graded
+    if (!file_type) return;
+
+    int type_matches = -1;
+    for (int i = CT_FIRST_FILE_TYPE; i < CT_PATTERN_COUNT; i++) {
+        if (strcmp(file_type, content_type_patterns[i]) == 0) { type_matches = hits[i]; break; }
+    }
+    if (type_matches < 0) type_matches = strcasestr_exists(value, file_type);
+    if (!type_matches) {
         report_add(rl, SEV_WARNING, "Content-Type '%s' does not match detected file type '%s'.", value, file_type);
     } else {
         report_add(rl, SEV_INFO, "Content-Type '%s' matches detected file type.", value);
     }
-    if (strcasestr_exists(file_type, "application/x-executable")) {
+    if (strcmp(file_type, "application/x-executable") == 0) {
         report_add(rl, SEV_CRITICAL, "Executable file type detected in response body.");
     }
 }
 
-// New function: Test rate limiting by sending multiple requests
-void analyze_rate_limiting(const char* url, ReportList* rl) {
-    CURL* curl = curl_easy_init();
-    if (!curl) { report_add(rl, SEV_WARNING, "Failed to init curl for rate limiting test."); return; }
-
-    MemoryStruct chunk = {0};
-    cJSON* headers_json = cJSON_CreateArray();
-    if (!headers_json) { curl_easy_cleanup(curl); return; }
-
-    curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &chunk);
-    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
-    curl_easy_setopt(curl, CURLOPT_HEADERDATA, headers_json);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (compatible; APIMonitor/1.0)");
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-
-    int rate_limit_detected = 0;
-    for (int i = 0; i < MAX_REQUESTS; i++) {
-        chunk.data = NULL;
-        chunk.size = 0;
-        cJSON_Delete(headers_json);
-        headers_json = cJSON_CreateArray();
-
-        CURLcode res = curl_easy_perform(curl);
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-
-        if (res != CURLE_OK) {
-            report_add(rl, SEV_WARNING, "Rate limiting test failed: %s.", curl_easy_strerror(res));
-            break;
-        }
-        if (http_code == 429) {
-            report_add(rl, SEV_INFO, "Rate limiting detected: HTTP 429 Too Many Requests.");
-            rate_limit_detected = 1;
-            break;
-        }
-        for (int j = 0; j < cJSON_GetArraySize(headers_json); j++) {
-            cJSON* item = cJSON_GetArrayItem(headers_json, j);
-            cJSON* name = cJSON_GetObjectItem(item, "name");
-            cJSON* value = cJSON_GetObjectItem(item, "value");
-            if (!cJSON_IsString(name) || !cJSON_IsString(value)) continue;
-            if (strcasecmp(name->valuestring, "x-rate-limit") == 0 ||
-                strcasecmp(name->valuestring, "retry-after") == 0) {
-                report_add(rl, SEV_INFO, "Rate limiting header '%s: %s' detected.", name->valuestring, value->valuestring);
-                rate_limit_detected = 1;
-                break;
-            }
-        }
-        free(chunk.data);
-        usleep(REQUEST_INTERVAL_MS * 1000); // Controlled delay
-    }
-    if (!rate_limit_detected) {
-        report_add(rl, SEV_WARNING, "No rate limiting detected after %d requests.", MAX_REQUESTS);
+// Test rate limiting by sending a burst of requests
+void analyze_rate_limiting(const char* url, const HttpScanConfig* config, ReportList* rl) {
+    ProbeBatch pb;
+    if (scan_batch_init(&pb, RATE_LIMIT_MAX_PER_ORIGIN, config) != 0) {
+        report_add(rl, SEV_WARNING, "Failed to init curl for rate limiting test.");
+        return;
     }
-    cJSON_Delete(headers_json);
-    curl_easy_cleanup(curl);
-}
-
-// New function: Test for XSS and SQL injection vulnerabilities
-void analyze_xss_sql_injection(const char* url, ReportList* rl) {
-    const char* payloads[MAX_PAYLOADS] = {
-        "<script>alert('xss')</script>", // XSS
-        "1' OR '1'='1",                // SQL Injection
-        "%3Cscript%3Ealert(1)%3C/script%3E" // URL-encoded XSS
-    };
-    const char* patterns[MAX_PAYLOADS] = {
-        "<script>alert\\('xss'\\)</script>",
-        "(error|exception|sql|syntax|database)",
-        "<script>alert\\(1\\)</script>"
-    };
 
-    CURL* curl = curl_easy_init();
-    if (!curl) { report_add(rl, SEV_WARNING, "Failed to init curl for injection test."); return; }
-
-    MemoryStruct chunk = {0};
-    cJSON* headers_json = cJSON_CreateArray();
-    if (!headers_json) { curl_easy_cleanup(curl); return; }
+    RateLimitBurst burst;
+    rate_limit_burst_start(&burst, &pb, url, config->burst_size, config->burst_rate);
+    rate_limit_burst_wait(&burst, &pb);
+    rate_limit_burst_evaluate(&burst, rl);
+    rate_limit_burst_free(&burst);
+    probe_batch_free(&pb);
+}
 
-    char* escaped_url = curl_easy_escape(curl, url, 0);
-    char test_url[1024];
-    regex_t regex[MAX_PAYLOADS];
-    for (int i = 0; i < MAX_PAYLOADS; i++) {
-        if (regcomp(&regex[i], patterns[i], REG_ICASE | REG_EXTENDED) != 0) {
-            report_add(rl, SEV_WARNING, "Failed to compile regex for payload %d.", i);
-            continue;
-        }
+// Test for XSS and SQL injection vulnerabilities
+void analyze_xss_sql_injection(const char* url, const HttpScanConfig* config, ReportList* rl) {
+    ProbeBatch pb;
+    if (scan_batch_init(&pb, PROBE_MAX_PER_ORIGIN, config) != 0) {
+        report_add(rl, SEV_WARNING, "Failed to init curl for injection test.");
+        return;
     }
 
-    for (int i = 0; i < MAX_PAYLOADS; i++) {
-        snprintf(test_url, sizeof(test_url), "%s?test=%s", escaped_url, curl_easy_escape(curl, payloads[i], 0));
-        chunk.data = NULL;
-        chunk.size = 0;
-        cJSON_Delete(headers_json);
-        headers_json = cJSON_CreateArray();
-
-        curl_easy_setopt(curl, CURLOPT_URL, test_url);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &chunk);
-        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
-        curl_easy_setopt(curl, CURLOPT_HEADERDATA, headers_json);
-        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Mozilla/5.0 (compatible; APIMonitor/1.0)");
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 1L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 2L);
-
-        CURLcode res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            report_add(rl, SEV_WARNING, "Injection test failed for payload %d: %s.", i, curl_easy_strerror(res));
-            continue;
-        }
-        if (chunk.data && regexec(&regex[i], chunk.data, 0, NULL, 0) == 0) {
-            report_add(rl, SEV_CRITICAL, "Potential %s vulnerability detected with payload: %s.",
-                       i == 1 ? "SQL Injection" : "XSS", payloads[i]);
-        }
-        free(chunk.data);
-    }
-    for (int i = 0; i < MAX_PAYLOADS; i++) regfree(&regex[i]);
-    curl_free(escaped_url);
-    cJSON_Delete(headers_json);
-    curl_easy_cleanup(curl);
+    InjectionScan scan;
+    injection_scan_schedule(&scan, &pb, url);
+    probe_batch_wait(&pb);
+    injection_scan_evaluate(&scan, rl);
+    injection_scan_free(&scan);
+    probe_batch_free(&pb);
 }
 
-// New function: Parse and analyze Set-Cookie headers
+// Parse and analyze every Set-Cookie header; the parser works on spans, so nothing is copied
 void analyze_cookies(const HeaderCollection* hc, ReportList* rl) {
-    Cookie cookies[10];
-    int cookie_count = 0;
-
-    for (int i = 0; i < hc->count; i++) {
-        if (strcasecmp(hc->headers[i].name, "set-cookie") != 0) continue;
-        if (cookie_count >= 10) break;
-
-        cookies[cookie_count].name = NULL;
-        cookies[cookie_count].attr_count = 0;
-        char* value = strdup(hc->headers[i].value);
-        if (!value) continue;
-
-        char* token = strtok(value, ";");
-        if (token) {
-            char* eq = strchr(token, '=');
-            if (eq) {
-                *eq = 0;
-                cookies[cookie_count].name = strdup(token);
-                trim_whitespace(&cookies[cookie_count].name);
-            }
-        }
-        while ((token = strtok(NULL, ";"))) {
-            trim_whitespace(&token);
-            char* eq = strchr(token, '=');
-            if (cookies[cookie_count].attr_count >= COOKIE_MAX_ATTRS) break;
-            if (eq) {
-                *eq = 0;
-                strncpy(cookies[cookie_count].attrs[cookies[cookie_count].attr_count].key, token, sizeof(cookies[cookie_count].attrs[0].key) - 1);
-                strncpy(cookies[cookie_count].attrs[cookies[cookie_count].attr_count].value, eq + 1, sizeof(cookies[cookie_count].attrs[0].value) - 1);
-            } else {
-                strncpy(cookies[cookie_count].attrs[cookies[cookie_count].attr_count].key, token, sizeof(cookies[cookie_count].attrs[0].key) - 1);
-                cookies[cookie_count].attrs[cookies[cookie_count].attr_count].value[0] = 0;
-            }
-            cookies[cookie_count].attr_count++;
+    for (int i = find_header_id(hc, HDR_SET_COOKIE); i >= 0; i = hc->headers[i].next - 1) {
+        CookieInfo c;
+        if (cookie_parse(header_value_at(hc, i), hc->headers[i].value_len, &c) != 0) {
+            report_add(rl, SEV_WARNING, "Malformed Set-Cookie header: %s", header_value_at(hc, i));
+            continue;
         }
-        cookie_count++;
-        free(value);
-    }
+        const int name_len = (int)c.name.len;
+        const char* name = c.name.ptr;
 
-    for (int i = 0; i < cookie_count; i++) {
-        int secure = 0, httponly = 0, samesite_strict = 0;
-        for (int j = 0; j < cookies[i].attr_count; j++) {
-            if (strcasecmp(cookies[i].attrs[j].key, "Secure") == 0) secure = 1;
-            if (strcasecmp(cookies[i].attrs[j].key, "HttpOnly") == 0) httponly = 1;
-            if (strcasecmp(cookies[i].attrs[j].key, "SameSite") == 0 &&
-                strcasecmp(cookies[i].attrs[j].value, "Strict") == 0) samesite_strict = 1;
-        }
+        // A deletion (Max-Age <= 0) cannot leak anything
+        if ((c.flags & COOKIE_HAS_MAX_AGE) && c.max_age <= 0) continue;
+
+        const int secure = (c.flags & COOKIE_SECURE) != 0;
+        const int httponly = (c.flags & COOKIE_HTTPONLY) != 0;
+        const int samesite_strict = (c.flags & COOKIE_SAMESITE_STRICT) != 0;
         if (!secure) {
-            report_add(rl, SEV_WARNING, "Cookie '%s' missing Secure attribute.", cookies[i].name ? cookies[i].name : "unknown");
+            report_add(rl, SEV_WARNING, "Cookie '%.*s' missing Secure attribute.", name_len, name);
         }
         if (!httponly) {
-            report_add(rl, SEV_WARNING, "Cookie '%s' missing HttpOnly attribute.", cookies[i].name ? cookies[i].name : "unknown");
+            report_add(rl, SEV_WARNING, "Cookie '%.*s' missing HttpOnly attribute.", name_len, name);
         }
         if (!samesite_strict) {
-            report_add(rl, SEV_WARNING, "Cookie '%s' missing SameSite=Strict attribute.", cookies[i].name ? cookies[i].name : "unknown");
+            report_add(rl, SEV_WARNING, "Cookie '%.*s' missing SameSite=Strict attribute.", name_len, name);
         }
         if (secure && httponly && samesite_strict) {
-            report_add(rl, SEV_INFO, "Cookie '%s' has secure attributes (Secure, HttpOnly, SameSite=Strict).", cookies[i].name ? cookies[i].name : "unknown");
+            report_add(rl, SEV_INFO, "Cookie '%.*s' has secure attributes (Secure, HttpOnly, SameSite=Strict).", name_len, name);
+        }
+
+        if ((c.flags & COOKIE_SAMESITE_NONE) && !secure) {
+            report_add(rl, SEV_WARNING, "Cookie '%.*s' sets SameSite=None without Secure; browsers reject it.", name_len, name);
+        }
+        if ((c.flags & COOKIE_PREFIX_SECURE) && !secure) {
+            report_add(rl, SEV_WARNING, "Cookie '%.*s' uses the __Secure- prefix without Secure.", name_len, name);
+        }
+        if ((c.flags & COOKIE_PREFIX_HOST) &&
+            (!secure || (c.flags & COOKIE_HAS_DOMAIN) || c.path.len != 1 || c.path.ptr[0] != '/')) {
+            report_add(rl, SEV_WARNING, "Cookie '%.*s' uses the __Host- prefix but is not Secure, host-only and Path=/.", name_len, name);
+        }
+        if (c.flags & COOKIE_HAS_DOMAIN) {
+            report_add(rl, SEV_INFO, "Cookie '%.*s' is shared with all subdomains of '%.*s'.", name_len, name, (int)c.domain.len, c.domain.ptr);
+        }
+        if ((c.flags & COOKIE_HAS_MAX_AGE) && c.max_age > COOKIE_MAX_AGE_LONG_LIVED) {
+            report_add(rl, SEV_INFO, "Cookie '%.*s' asks to persist for %ld days; browsers cap this at 400.", name_len, name, c.max_age / 86400);
         }
-    }
-    for (int i = 0; i < cookie_count; i++) {
-        if (cookies[i].name) free(cookies[i].name);
     }
 }
 
-grading_result grading_analyze(cJSON* headers_json, const char* url, char* body, size_t body_size) {
+typedef struct {
+    const HeaderCollection* hc;
+    const BodyInspector* body;
+    ReportList* rl;
+} HeaderContext;
+
+typedef void (*HeaderAnalyzer)(const char* value, const HeaderContext* ctx);
+
+static void dispatch_hsts(const char* value, const HeaderContext* ctx) { analyze_hsts(value, ctx->rl); }
+static void dispatch_csp(const char* value, const HeaderContext* ctx) { analyze_csp(value, ctx->rl); }
+static void dispatch_x_content_type_options(const char* value, const HeaderContext* ctx) { analyze_x_content_type_options(value, ctx->rl); }
+static void dispatch_x_frame_options(const char* value, const HeaderContext* ctx) { analyze_x_frame_options(value, ctx->rl); }
+static void dispatch_referrer_policy(const char* value, const HeaderContext* ctx) { analyze_referrer_policy(value, ctx->rl); }
+static void dispatch_feature_policy(const char* value, const HeaderContext* ctx) { analyze_feature_policy(value, ctx->rl); }
+static void dispatch_content_type(const char* value, const HeaderContext* ctx) {
+    analyze_content_type(value, ctx->body->headers_only ? NULL : ctx->body->file_type, ctx->rl);
+}
+static void dispatch_content_language(const char* value, const HeaderContext* ctx) { analyze_content_language(value, ctx->rl); }
+
+static void dispatch_cache_control(const char* value, const HeaderContext* ctx) {
+    int p_idx = find_header_id(ctx->hc, HDR_PRAGMA);
+    int e_idx = find_header_id(ctx->hc, HDR_EXPIRES);
+    analyze_cache_headers(value,
+                          p_idx >= 0 ? header_value_at(ctx->hc, p_idx) : NULL,
+                          e_idx >= 0 ? header_value_at(ctx->hc, e_idx) : NULL,
+                          ctx->rl);
+}
+
+// Per-header analyzers, indexed by HeaderId; headers without an entry are only used by other checks
+static const HeaderAnalyzer header_analyzers[HDR_COUNT] = {
+    [HDR_STRICT_TRANSPORT_SECURITY] = dispatch_hsts,
+    [HDR_CONTENT_SECURITY_POLICY] = dispatch_csp,
+    [HDR_X_CONTENT_TYPE_OPTIONS] = dispatch_x_content_type_options,
+    [HDR_X_FRAME_OPTIONS] = dispatch_x_frame_options,
+    [HDR_REFERRER_POLICY] = dispatch_referrer_policy,
+    [HDR_PERMISSIONS_POLICY] = dispatch_feature_policy,
+    [HDR_FEATURE_POLICY] = dispatch_feature_policy,
+    [HDR_CACHE_CONTROL] = dispatch_cache_control,
+    [HDR_CONTENT_TYPE] = dispatch_content_type,
+    [HDR_CONTENT_LANGUAGE] = dispatch_content_language,
+};
+
+grading_result grading_analyze(const HeaderCollection* hc, const char* url, const BodyInspector* body, const HttpScanConfig* config) {
     grading_result res = { .score = 100, .missing = cJSON_CreateArray(), .notes = cJSON_CreateArray() };
-    HeaderCollection hc = {0};
-    int headers_count = cJSON_GetArraySize(headers_json);
 
-    for (int i = 0; i < headers_count; i++) {
-        cJSON* item = cJSON_GetArrayItem(headers_json, i);
-        cJSON* name_json = cJSON_GetObjectItem(item, "name");
-        cJSON* value_json = cJSON_GetObjectItem(item, "value");
-        if (!cJSON_IsString(name_json) || !cJSON_IsString(value_json)) continue;
-        add_header(&hc, name_json->valuestring, value_json->valuestring);
+    // The burst runs in its own batch while the headers are analyzed; injection probes only start once it
+    // is over, so they neither queue ahead of it nor load the server it is timing
+    ProbeBatch burst_pb;
+    RateLimitBurst burst = {0};
+    int burst_ready = scan_batch_init(&burst_pb, RATE_LIMIT_MAX_PER_ORIGIN, config) == 0;
+    if (burst_ready) {
+        rate_limit_burst_start(&burst, &burst_pb, url, config->burst_size, config->burst_rate);
+        probe_batch_step(&burst_pb);
     }
 
     ReportList rl;
     report_init(&rl);
 
-    analyze_security_headers_presence(&hc, &rl);
-    for (int i = 0; i < hc.count; i++) {
-        const HttpHeader* hdr = &hc.headers[i];
-        if (strcasecmp(hdr->name, "strict-transport-security") == 0) {
-            analyze_hsts(hdr->value, &rl);
-        } else if (strcasecmp(hdr->name, "x-frame-options") == 0) {
-            analyze_x_frame_options(hdr->value, &rl);
-        } else if (strcasecmp(hdr->name, "content-security-policy") == 0) {
-            analyze_csp(hdr->value, &rl);
-        } else if (strcasecmp(hdr->name, "x-content-type-options") == 0) {
-            analyze_x_content_type_options(hdr->value, &rl);
-        } else if (strcasecmp(hdr->name, "referrer-policy") == 0) {
-            analyze_referrer_policy(hdr->value, &rl);
-        } else if (strcasecmp(hdr->name, "permissions-policy") == 0 || strcasecmp(hdr->name, "feature-policy") == 0) {
-            analyze_feature_policy(hdr->value, &rl);
-        } else if (strcasecmp(hdr->name, "cache-control") == 0) {
-            const char* pragma_val = NULL, *expires_val = NULL;
-            int p_idx = find_header(&hc, "pragma");
-            if (p_idx >= 0) pragma_val = hc.headers[p_idx].value;
-            int e_idx = find_header(&hc, "expires");
-            if (e_idx >= 0) expires_val = hc.headers[e_idx].value;
-            analyze_cache_headers(hdr->value, pragma_val, expires_val, &rl);
-        } else if (strcasecmp(hdr->name, "content-type") == 0) {
-            analyze_content_type(hdr->value, body, body_size, &rl);
-        } else if (strcasecmp(hdr->name, "content-language") == 0) {
-            analyze_content_language(hdr->value, &rl);
+    analyze_security_headers_presence(hc, &rl);
+    const HeaderContext ctx = { .hc = hc, .body = body, .rl = &rl };
+    for (int i = 0; i < hc->count; i++) {
+        const HttpHeader* hdr = &hc->headers[i];
+        HeaderAnalyzer analyzer = header_analyzers[hdr->id];
+        // Repeated headers are kept for the raw view, but each analyzer grades the first occurrence
+        if (analyzer && hc->by_id[hdr->id] == i + 1) analyzer(header_value_at(hc, i), &ctx);
+        if (burst_ready) {
+            rate_limit_burst_pump(&burst, &burst_pb);
+            probe_batch_step(&burst_pb);
         }
     }
-    analyze_cookies(&hc, &rl);
-    analyze_rate_limiting(url, &rl);
-    analyze_xss_sql_injection(url, &rl);
-
-    ReportEntry* entry = rl.head;
-    while (entry) {
-        if (entry->severity == SEV_CRITICAL) {
-            res.score -= 50;
-            cJSON_AddItemToArray(res.missing, cJSON_CreateString(entry->message));
-        } else if (entry->severity == SEV_WARNING) {
-            res.score -= 10;
-            cJSON_AddItemToArray(res.notes, cJSON_CreateString(entry->message));
-        } else {
-            cJSON_AddItemToArray(res.notes, cJSON_CreateString(entry->message));
+    analyze_cookies(hc, &rl);
+    int encoding_idx = find_header_id(hc, HDR_CONTENT_ENCODING);
+    analyze_compression(encoding_idx >= 0 ? header_value_at(hc, encoding_idx) : NULL, body, &rl);
+
+    if (burst_ready) rate_limit_burst_wait(&burst, &burst_pb);
+    rate_limit_burst_evaluate(&burst, &rl);
+    rate_limit_burst_free(&burst);
+    if (burst_ready) probe_batch_free(&burst_pb);
+
+    if (config->body_checks & HTTP_CHECK_INJECTION) {
+        ProbeBatch pb;
+        InjectionScan injection = {0};
+        if (scan_batch_init(&pb, PROBE_MAX_PER_ORIGIN, config) == 0) {
+            injection_scan_schedule(&injection, &pb, url);
+            probe_batch_wait(&pb);
         }
-        entry = entry->next;
+        injection_scan_evaluate(&injection, &rl);
+        injection_scan_free(&injection);
+        probe_batch_free(&pb);
     }
-    if (res.score < 0) res.score = 0;
+
+    grading_score(hc, &rl, &res);
 
     report_print_and_free(&rl);
     return res;
 }
 
-void grading_result_free(grading_result* result) {
-    if (!result) return;
-    if (result->missing) { cJSON_Delete(result->missing); result->missing = NULL; }
-    if (result->notes) { cJSON_Delete(result->notes); result->notes = NULL; }
-}
-
 int strcasestr_exists(const char* haystack, const char* needle) {
     if (!haystack || !needle) return 0;
-    size_t needle_len = strlen(needle);
-    size_t haystack_len = strlen(haystack);
-    if (needle_len == 0) return 1;
-    for (size_t i = 0; i <= haystack_len - needle_len; i++) {
-        if (strncasecmp(&haystack[i], needle, needle_len) == 0) return 1;
-    }
-    return 0;
+    return simd_casefind(haystack, strlen(haystack), needle, strlen(needle)) != NULL;
 }
 
 static const char* severity_to_str(Severity sev) {
@@ -668,20 +720,50 @@ void analyze_csp(const char* csp, ReportList* rl) {
         report_add(rl, SEV_WARNING, "Content-Security-Policy header missing or empty.");
         return;
     }
-    if (strcasestr_exists(csp, "'unsafe-inline'")) {
+    CspEvaluation eval;
+    if (csp_evaluate_cached(csp, &eval) != 0) {
+        report_add(rl, SEV_WARNING, "Content-Security-Policy could not be parsed.");
+        return;
+    }
+    const char* script_from = csp_directive_name(eval.script_from);
+
+    if (eval.issues & CSP_ISSUE_SCRIPT_UNRESTRICTED) {
+        report_add(rl, SEV_WARNING, "CSP has neither script-src nor default-src; scripts are unrestricted.");
+    }
+    if (eval.issues & CSP_ISSUE_SCRIPT_UNSAFE_INLINE) {
         report_add(rl, SEV_WARNING, "CSP contains 'unsafe-inline' which weakens script protections.");
     }
-    if (strcasestr_exists(csp, "'unsafe-eval'")) {
+    if (eval.issues & CSP_ISSUE_SCRIPT_UNSAFE_EVAL) {
         report_add(rl, SEV_WARNING, "CSP contains 'unsafe-eval' which weakens script protections.");
     }
-    if (!strcasestr_exists(csp, "default-src")) {
+    if (eval.issues & CSP_ISSUE_SCRIPT_ANY_HOST) {
+        report_add(rl, SEV_WARNING, "CSP %s allows scripts from any host ('*', 'http:' or 'https:').", script_from);
+    }
+    if (eval.issues & CSP_ISSUE_SCRIPT_DATA) {
+        report_add(rl, SEV_WARNING, "CSP %s allows 'data:' scripts.", script_from);
+    }
+    if (eval.issues & CSP_ISSUE_STRICT_DYNAMIC_ALONE) {
+        report_add(rl, SEV_WARNING, "CSP uses 'strict-dynamic' without a nonce or hash; no script can load.");
+    } else if (eval.script & CSP_SRC_STRICT_DYNAMIC) {
+        report_add(rl, SEV_INFO, "CSP uses 'strict-dynamic' with nonces or hashes; host allowlists are ignored.");
+    } else if (eval.script & (CSP_SRC_NONCE | CSP_SRC_HASH)) {
+        report_add(rl, SEV_INFO, "CSP %s uses nonces or hashes.", script_from);
+    }
+    if (eval.issues & CSP_ISSUE_OBJECT_NOT_NONE) {
+        report_add(rl, SEV_WARNING, "CSP object-src is not 'none' (effective via %s); plugins can load content.",
+                   eval.object_from == CSP_DIR_OTHER ? "no directive" : csp_directive_name(eval.object_from));
+    }
+    if (eval.issues & CSP_ISSUE_BASE_URI_MISSING) {
+        // Without base-uri an injected <base> can redirect nonce-carrying relative script loads
+        report_add(rl, (eval.script & (CSP_SRC_NONCE | CSP_SRC_HASH)) ? SEV_WARNING : SEV_INFO,
+                   "CSP missing 'base-uri' directive; consider base-uri 'none' or 'self'.");
+    }
+    if (eval.issues & CSP_ISSUE_NO_DEFAULT_SRC) {
         report_add(rl, SEV_WARNING, "CSP missing 'default-src' directive; consider adding for better defaults.");
+    } else if (eval.issues & CSP_ISSUE_DEFAULT_SRC_RISKY) {
+        report_add(rl, SEV_WARNING, "CSP default-src allows wildcard or risky sources which can weaken security.");
     } else {
-        if (strcasestr_exists(csp, "default-src *") || strcasestr_exists(csp, "default-src 'unsafe-inline'") || strcasestr_exists(csp, "default-src data:")) {
-            report_add(rl, SEV_WARNING, "CSP default-src allows wildcard or risky sources which can weaken security.");
-        } else {
-            report_add(rl, SEV_INFO, "CSP default-src directive looks restrictive.");
-        }
+        report_add(rl, SEV_INFO, "CSP default-src directive looks restrictive.");
     }
 }
 
@@ -722,19 +804,16 @@ void analyze_feature_policy(const char* value, ReportList* rl) {
         report_add(rl, SEV_INFO, "Feature-Policy or Permissions-Policy header missing.");
         return;
     }
-    char val_copy[MAX_HEADER_VALUE];
-    strncpy(val_copy, value, sizeof(val_copy)-1);
-    val_copy[sizeof(val_copy)-1] = 0;
-    for (size_t i = 0; i < strlen(val_copy); ++i) val_copy[i] = (char)tolower((unsigned char)val_copy[i]);
-    if (strstr(val_copy, "camera 'none'") || strstr(val_copy, "microphone 'none'")) {
+    const size_t len = strlen(value);
+    if (simd_casefind(value, len, "camera 'none'", 13) || simd_casefind(value, len, "microphone 'none'", 17)) {
         report_add(rl, SEV_INFO, "Feature-Policy restricts camera and microphone usage.");
     } else {
         report_add(rl, SEV_WARNING, "Feature-Policy does not restrict sensitive features like camera or microphone.");
     }
-    if (strstr(val_copy, "geolocation 'none'")) {
+    if (simd_casefind(value, len, "geolocation 'none'", 18)) {
         report_add(rl, SEV_INFO, "Feature-Policy restricts geolocation.");
     }
-    if (strstr(val_copy, "*") || strstr(val_copy, "allow=*")) {
+    if (memchr(value, '*', len)) { // also covers "allow=*"
         report_add(rl, SEV_WARNING, "Feature-Policy includes wildcard or very permissive allow rules.");
     }
 }
@@ -773,18 +852,32 @@ void analyze_content_language(const char* value, ReportList* rl) {
     report_add(rl, SEV_INFO, "Content-Language set to '%s'.", value);
 }
 
+void analyze_compression(const char* encoding, const BodyInspector* body, ReportList* rl) {
+    if (body->headers_only || body->total_size == 0) return;
+    if (body->compression_bomb) {
+        report_add(rl, SEV_WARNING, "Decompression stopped: body expanded more than %d:1 (possible compression bomb).", BODY_MAX_COMPRESSION_RATIO);
+    }
+    if (!encoding || strcasecmp(encoding, "identity") == 0) {
+        report_add(rl, SEV_INFO, "Response body is not compressed (%zu bytes read).", body->total_size);
+        return;
+    }
+    // libcurl decodes whole network reads at once, so a transfer stopped early has no meaningful ratio
+    if (body->stopped || !body->wire_size) {
+        report_add(rl, SEV_INFO, "Response body uses '%s' content encoding.", encoding);
+        return;
+    }
+    report_add(rl, SEV_INFO, "Response body uses '%s' content encoding: %zu bytes on the wire decoded to %zu (%.1f:1).",
+               encoding, body->wire_size, body->total_size, (double)body->total_size / (double)body->wire_size);
+}
+
 void analyze_security_headers_presence(const HeaderCollection* hc, ReportList* rl) {
-    const char* critical_headers[] = {
-        "strict-transport-security", "content-security-policy", "x-content-type-options",
-        "x-frame-options", "referrer-policy", "permissions-policy"
+    static const HeaderId critical_headers[] = {
+        HDR_STRICT_TRANSPORT_SECURITY, HDR_CONTENT_SECURITY_POLICY, HDR_X_CONTENT_TYPE_OPTIONS,
+        HDR_X_FRAME_OPTIONS, HDR_REFERRER_POLICY, HDR_PERMISSIONS_POLICY
     };
     for (size_t i = 0; i < sizeof(critical_headers)/sizeof(critical_headers[0]); i++) {
-        int found = 0;
-        for (int j = 0; j < hc->count; j++) {
-            if (strcasecmp(hc->headers[j].name, critical_headers[i]) == 0) { found = 1; break; }
-        }
-        if (!found) {
-            report_add(rl, SEV_WARNING, "Security header '%s' is missing.", critical_headers[i]);
+        if (find_header_id(hc, critical_headers[i]) < 0) {
+            report_add(rl, SEV_WARNING, "Security header '%s' is missing.", header_name(critical_headers[i]));
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "../../include/scanner/http_probe.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Bodies are inspected as they stream in and never buffered; returning short aborts the transfer
+static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    size_t total_size = size * nmemb;
+    HttpProbe* probe = userp;
+
+    if (probe->body.stopped) return 0;
+    // The digest covers exactly the bytes the inspector sees, so it never keeps a transfer alive
+    if (probe->digest) EVP_DigestUpdate(probe->digest, contents, total_size);
+    if (body_inspector_feed(&probe->body, contents, total_size)) return 0;
+
+    // Content decoding happens before this callback, so the size cap already bounds decoded bytes;
+    // the ratio check stops a bomb well before a large cap is reached
+    if (probe->body.total_size > BODY_RATIO_CHECK_MIN) {
+        curl_off_t wire = 0;
+        curl_easy_getinfo(probe->easy, CURLINFO_SIZE_DOWNLOAD_T, &wire);
+        if (wire > 0 && probe->body.total_size / (size_t)wire > BODY_MAX_COMPRESSION_RATIO) {
+            probe->body.compression_bomb = 1;
+            probe->body.stopped = 1;
+            return 0;
+        }
+    }
+    return total_size;
+}
+
+// Header lines go straight into the probe's HeaderCollection, no intermediate copies
+static size_t HeaderCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    size_t total_size = nitems * size;
+    HttpProbe* probe = userdata;
+
+    // A new status line means a redirect hop; only the final response's headers are kept
+    if (total_size >= 5 && memcmp(buffer, "HTTP/", 5) == 0) {
+        header_collection_reset(&probe->headers);
+        return total_size;
+    }
+
+    const char* colon_pos = memchr(buffer, ':', total_size);
+    if (!colon_pos) return total_size;
+
+    size_t name_len = colon_pos - buffer;
+    while (name_len > 0 && (buffer[name_len - 1] == ' ' || buffer[name_len - 1] == '\t')) name_len--;
+
+    const char* value_start = colon_pos + 1;
+    add_header_n(&probe->headers, buffer, name_len, value_start, total_size - (value_start - buffer));
+    return total_size;
+}
+
+int probe_batch_init(ProbeBatch* pb, long max_per_origin, size_t max_body_size) {
+    if (!pb) return -1;
+    memset(pb, 0, sizeof(*pb));
+    pb->max_body_size = max_body_size;
+
+    pb->multi = curl_multi_init();
+    if (!pb->multi) { fprintf(stderr, "Failed to init curl multi handle\n"); return -1; }
+
+    // Transfers beyond the cap queue inside libcurl until a connection frees up
+    curl_multi_setopt(pb->multi, CURLMOPT_MAX_HOST_CONNECTIONS, max_per_origin > 0 ? max_per_origin : 1L);
+    return 0;
+}
+
+// Later transfers wait for the first connection's ALPN result and then ride it as HTTP/2 streams;
+// if the origin only speaks HTTP/1.1 they fall back to separate connections under the same cap
+void probe_batch_enable_http2(ProbeBatch* pb, CURLSH* share) {
+    if (!pb || !pb->multi) return;
+    pb->multiplex = 1;
+    pb->share = share;
+    curl_multi_setopt(pb->multi, CURLMOPT_PIPELINING, (long)CURLPIPE_MULTIPLEX);
+}
+
+// Shared connection cache, so consecutive batches of one analysis keep using the same connection
+CURLSH* probe_share_init(void) {
+    CURLSH* share = curl_share_init();
+    if (!share) return NULL;
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    return share;
+}
+
+void probe_share_free(CURLSH* share) {
+    if (share) curl_share_cleanup(share);
+}
+
+HttpProbe* probe_batch_add(ProbeBatch* pb, const char* url, long timeout_s) {
+    if (!pb || !pb->multi || !url) return NULL;
+
+    if (pb->count == pb->capacity) {
+        size_t new_capacity = pb->capacity ? pb->capacity * 2 : 16;
+        HttpProbe** ptr = realloc(pb->probes, new_capacity * sizeof(*ptr));
+        if (!ptr) { fprintf(stderr, "Failed to grow probe batch\n"); return NULL; }
+        pb->probes = ptr;
+        pb->capacity = new_capacity;
+    }
+
+    HttpProbe* probe = calloc(1, sizeof(*probe));
+    if (!probe) return NULL;
+
+    probe->easy = curl_easy_init();
+    if (!probe->easy) {
+        free(probe);
+        return NULL;
+    }
+    body_inspector_init(&probe->body, pb->max_body_size);
+
+    curl_easy_setopt(probe->easy, CURLOPT_URL, url);
+    curl_easy_setopt(probe->easy, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(probe->easy, CURLOPT_WRITEDATA, probe);
+    curl_easy_setopt(probe->easy, CURLOPT_HEADERFUNCTION, HeaderCallback);
+    curl_easy_setopt(probe->easy, CURLOPT_HEADERDATA, probe);
+    curl_easy_setopt(probe->easy, CURLOPT_PRIVATE, probe);
+    curl_easy_setopt(probe->easy, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(probe->easy, CURLOPT_USERAGENT, "Mozilla/5.0 (compatible; APIMonitor/1.0)");
+    curl_easy_setopt(probe->easy, CURLOPT_TIMEOUT, timeout_s);
+    curl_easy_setopt(probe->easy, CURLOPT_SSL_VERIFYPEER, 1L);
+    curl_easy_setopt(probe->easy, CURLOPT_SSL_VERIFYHOST, 2L);
+    curl_easy_setopt(probe->easy, CURLOPT_NOSIGNAL, 1L);
+    // Empty string: offer every encoding this libcurl can decode (gzip, deflate, br, zstd as built)
+    curl_easy_setopt(probe->easy, CURLOPT_ACCEPT_ENCODING, "");
+    if (pb->multiplex) {
+        curl_easy_setopt(probe->easy, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(probe->easy, CURLOPT_PIPEWAIT, 1L);
+    }
+    if (pb->share) curl_easy_setopt(probe->easy, CURLOPT_SHARE, pb->share);
+
+    if (curl_multi_add_handle(pb->multi, probe->easy) != CURLM_OK) {
+        fprintf(stderr, "Failed to add probe for %s\n", url);
+        curl_easy_cleanup(probe->easy);
+        free(probe);
+        return NULL;
+    }
+
+    pb->probes[pb->count++] = probe;
+    return probe;
+}
+
+// Both setters must run before the first probe_batch_step, while the transfer has not started yet
+int probe_set_validators(HttpProbe* probe, const char* etag, const char* last_modified) {
+    if (!probe || (!etag && !last_modified)) return -1;
+    char line[512];
+    if (etag && *etag) {
+        snprintf(line, sizeof(line), "If-None-Match: %s", etag);
+        probe->request_headers = curl_slist_append(probe->request_headers, line);
+    }
+    if (last_modified && *last_modified) {
+        snprintf(line, sizeof(line), "If-Modified-Since: %s", last_modified);
+        probe->request_headers = curl_slist_append(probe->request_headers, line);
+    }
+    if (!probe->request_headers) return -1;
+    curl_easy_setopt(probe->easy, CURLOPT_HTTPHEADER, probe->request_headers);
+    return 0;
+}
+
+int probe_track_digest(HttpProbe* probe) {
+    if (!probe) return -1;
+    if (probe->digest) return 0;
+    probe->digest = EVP_MD_CTX_new();
+    if (!probe->digest || EVP_DigestInit_ex(probe->digest, EVP_sha256(), NULL) != 1) {
+        EVP_MD_CTX_free(probe->digest);
+        probe->digest = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Drive every transfer as far as it can go without blocking; returns the number still running
+int probe_batch_step(ProbeBatch* pb) {
+    if (!pb || !pb->multi) return 0;
+
+    curl_multi_perform(pb->multi, &pb->running);
+
+    CURLMsg* msg;
+    int msgs_left = 0;
+    while ((msg = curl_multi_info_read(pb->multi, &msgs_left))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        HttpProbe* probe = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&probe);
+        if (!probe) continue;
+        probe->result = msg->data.result;
+        if (probe->result == CURLE_WRITE_ERROR && probe->body.stopped) probe->result = CURLE_OK;
+        body_inspector_finish(&probe->body);
+        if (probe->digest) {
+            unsigned int len = 0;
+            probe->has_digest = EVP_DigestFinal_ex(probe->digest, probe->body_digest, &len) == 1 && len == PROBE_DIGEST_SIZE;
+        }
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &probe->http_code);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_HTTP_VERSION, &probe->http_version);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_NUM_CONNECTS, &probe->new_connections);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRETRANSFER_TIME_T, &probe->pretransfer_us);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_STARTTRANSFER_TIME_T, &probe->ttfb_us);
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_TOTAL_TIME_T, &probe->total_us);
+        curl_off_t wire = 0;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_SIZE_DOWNLOAD_T, &wire);
+        probe->body.wire_size = wire > 0 ? (size_t)wire : 0;
+        probe->done = 1;
+    }
+    return pb->running;
+}
+
+void probe_batch_wait(ProbeBatch* pb) {
+    if (!pb || !pb->multi) return;
+    while (probe_batch_step(pb) > 0) {
+        if (curl_multi_poll(pb->multi, NULL, 0, PROBE_POLL_TIMEOUT_MS, NULL) != CURLM_OK) break;
+    }
+}
+
+void probe_batch_free(ProbeBatch* pb) {
+    if (!pb) return;
+    for (size_t i = 0; i < pb->count; i++) {
+        HttpProbe* probe = pb->probes[i];
+        if (pb->multi) curl_multi_remove_handle(pb->multi, probe->easy);
+        curl_easy_cleanup(probe->easy);
+        header_collection_free(&probe->headers);
+        curl_slist_free_all(probe->request_headers);
+        EVP_MD_CTX_free(probe->digest);
+        free(probe);
+    }
+    free(pb->probes);
+    if (pb->multi) curl_multi_cleanup(pb->multi);
+    memset(pb, 0, sizeof(*pb));
+}
+
+uint64_t probe_monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,320 @@
+#include "../../include/scanner/injection_engine.h"
+#include <cjson/cJSON.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define INJECTION_MAX_FILE (1024 * 1024)
+
+// Used when no corpus file can be read
+static const struct {
+    const char* payload;
+    const char* kind;
+    const char* signatures[6];
+} builtin_payloads[] = {
+    { "<script>alert('xss')</script>", "XSS", { "<script>alert('xss')</script>" } },
+    { "1' OR '1'='1", "SQL Injection", { "error", "exception", "sql", "syntax", "database" } },
+    { "%3Cscript%3Ealert(1)%3C/script%3E", "XSS", { "<script>alert(1)</script>" } } // URL-encoded XSS
+};
+
+static InjectionCorpus corpus;
+static int corpus_ready;
+static char corpus_path[4096];
+static pthread_once_t corpus_once = PTHREAD_ONCE_INIT;
+
+static void corpus_free(InjectionCorpus* c) {
+    for (size_t i = 0; i < c->payload_count; i++) {
+        free(c->payloads[i].payload);
+        free(c->payloads[i].kind);
+    }
+    for (size_t i = 0; i < c->signature_count; i++) free(c->signatures[i]);
+    free(c->payloads);
+    free(c->signatures);
+    pattern_matcher_free(&c->matcher);
+    memset(c, 0, sizeof(*c));
+}
+
+static int corpus_add(InjectionCorpus* c, const char* payload, const char* kind, const char* const* signatures, size_t count) {
+    InjectionPayload* payloads = realloc(c->payloads, (c->payload_count + 1) * sizeof(*payloads));
+    if (!payloads) return -1;
+    c->payloads = payloads;
+    char** sigs = realloc(c->signatures, (c->signature_count + count) * sizeof(*sigs));
+    if (!sigs) return -1;
+    c->signatures = sigs;
+
+    InjectionPayload* p = &c->payloads[c->payload_count];
+    p->payload = strdup(payload);
+    p->kind = strdup(kind);
+    p->signature_first = c->signature_count;
+    p->signature_count = 0;
+    c->payload_count++;
+    if (!p->payload || !p->kind) return -1;
+    for (size_t i = 0; i < count; i++) {
+        if (!(c->signatures[c->signature_count] = strdup(signatures[i]))) return -1;
+        c->signature_count++;
+        p->signature_count++;
+    }
+    return 0;
+}
+
+static int corpus_load_builtin(InjectionCorpus* c) {
+    for (size_t i = 0; i < sizeof(builtin_payloads) / sizeof(builtin_payloads[0]); i++) {
+        size_t count = 0;
+        while (count < 6 && builtin_payloads[i].signatures[count]) count++;
+        if (corpus_add(c, builtin_payloads[i].payload, builtin_payloads[i].kind, builtin_payloads[i].signatures, count) != 0) return -1;
+    }
+    return 0;
+}
+
+// {"payloads": [{"payload": "...", "kind": "XSS", "signatures": ["..."]}, ...]}
+static int corpus_load_file(InjectionCorpus* c, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return -1;
+    char* text = malloc(INJECTION_MAX_FILE + 1);
+    if (!text) { fclose(fp); return -1; }
+    size_t n = fread(text, 1, INJECTION_MAX_FILE, fp);
+    fclose(fp);
+    text[n] = 0;
+    cJSON* root = cJSON_Parse(text);
+    free(text);
+    if (!root) { fprintf(stderr, "Injection corpus %s is not valid JSON\n", path); return -1; }
+
+    int rc = 0;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItemCaseSensitive(root, "payloads")) {
+        const cJSON* payload = cJSON_GetObjectItemCaseSensitive(item, "payload");
+        const cJSON* kind = cJSON_GetObjectItemCaseSensitive(item, "kind");
+        const cJSON* signatures = cJSON_GetObjectItemCaseSensitive(item, "signatures");
+        if (!cJSON_IsString(payload) || !cJSON_IsString(kind) || !cJSON_IsArray(signatures)) {
+            fprintf(stderr, "Injection corpus %s: skipping malformed payload entry\n", path);
+            continue;
+        }
+        const char* sigs[64];
+        size_t count = 0;
+        const cJSON* sig;
+        cJSON_ArrayForEach(sig, signatures) {
+            if (cJSON_IsString(sig) && sig->valuestring[0] && count < 64) sigs[count++] = sig->valuestring;
+        }
+        if (count == 0) continue;
+        if (corpus_add(c, payload->valuestring, kind->valuestring, sigs, count) != 0) { rc = -1; break; }
+    }
+    cJSON_Delete(root);
+    if (rc == 0 && c->payload_count == 0) {
+        fprintf(stderr, "Injection corpus %s has no usable payloads\n", path);
+        rc = -1;
+    }
+    return rc;
+}
+
+static void corpus_build(void) {
+    const char* path = corpus_path[0] ? corpus_path : getenv(INJECTION_PAYLOADS_ENV);
+    if (!path) path = INJECTION_PAYLOADS_DEFAULT_PATH;
+
+    if (corpus_load_file(&corpus, path) != 0) {
+        corpus_free(&corpus);
+        fprintf(stderr, "Using built-in injection payloads; could not load %s\n", path);
+        if (corpus_load_builtin(&corpus) != 0) { corpus_free(&corpus); return; }
+    }
+    if (pattern_matcher_build(&corpus.matcher, (const char* const*)corpus.signatures, corpus.signature_count) != 0) {
+        corpus_free(&corpus);
+        return;
+    }
+    corpus_ready = 1;
+}
+
+// Loads once from path, $INJECTION_PAYLOADS_PATH or the default location; later calls are no-ops
+int injection_corpus_init(const char* path) {
+    if (path) snprintf(corpus_path, sizeof(corpus_path), "%s", path);
+    pthread_once(&corpus_once, corpus_build);
+    return corpus_ready ? 0 : -1;
+}
+
+const InjectionCorpus* injection_corpus_get(void) {
+    pthread_once(&corpus_once, corpus_build);
+    return corpus_ready ? &corpus : NULL;
+}
+
+void injection_corpus_cleanup(void) {
+    corpus_free(&corpus);
+    corpus_ready = 0;
+}
+
+typedef struct {
+    const char* name;
+    size_t name_len;
+    const char* value; // just past the '=', or the end of the name when there is none
+    size_t value_len;
+} QueryParam;
+
+// Finds the parameters to inject into: the first occurrence of each distinct non-empty name, at most max.
+// Returns the number found; *more is set when further names were left out.
+static size_t parse_query(const char* query, size_t query_len, QueryParam* params, size_t max, int* more) {
+    size_t count = 0;
+    const char* end = query + query_len;
+    *more = 0;
+    for (const char* p = query; p < end; p++) {
+        const char* amp = memchr(p, '&', (size_t)(end - p));
+        const char* seg_end = amp ? amp : end;
+        const char* eq = memchr(p, '=', (size_t)(seg_end - p));
+        size_t name_len = (size_t)((eq ? eq : seg_end) - p);
+        int duplicate = name_len == 0;
+        for (size_t i = 0; i < count && !duplicate; i++) {
+            duplicate = params[i].name_len == name_len && memcmp(params[i].name, p, name_len) == 0;
+        }
+        if (!duplicate) {
+            if (count == max) {
+                *more = 1;
+                break;
+            }
+            params[count].name = p;
+            params[count].name_len = name_len;
+            params[count].value = eq ? eq + 1 : seg_end;
+            params[count].value_len = (size_t)(seg_end - params[count].value);
+            count++;
+        }
+        p = seg_end;
+    }
+    return count;
+}
+
+// The URL with only the target's value replaced by the escaped payload, every other byte of the query kept
+// as it was; without a target, name=<payload> is appended after whatever query there was
+static char* build_probe_url(const char* url, size_t url_len, const char* query, const QueryParam* target,
+                             const char* name, const char* escaped) {
+    size_t size = url_len + strlen(name) + strlen(escaped) + 3;
+    char* url_out = malloc(size);
+    if (!url_out) return NULL;
+
+    if (target) {
+        size_t head = (size_t)(target->value - url);
+        int add_eq = target->value == target->name + target->name_len; // "?flag" has no '=' to keep
+        const char* tail = target->value + target->value_len;
+        snprintf(url_out, size, "%.*s%s%s%.*s", (int)head, url, add_eq ? "=" : "", escaped,
+                 (int)(url + url_len - tail), tail);
+    } else {
+        const char* sep = !query ? "?" : query == url + url_len ? "" : "&";
+        snprintf(url_out, size, "%.*s%s%s=%s", (int)url_len, url, sep, name, escaped);
+    }
+    return url_out;
+}
+
+static HttpProbe* add_probe(ProbeBatch* pb, const char* url, const InjectionCorpus* c, const InjectionPayload* payload) {
+    HttpProbe* probe = probe_batch_add(pb, url, PROBE_TIMEOUT_S);
+    if (!probe) return NULL;
+    // Each transfer ends once the fingerprint prefix is read and the payload's signatures have matched
+    if (payload) body_inspector_set_patterns(&probe->body, &c->matcher, payload->signature_first, payload->signature_count);
+    probe->body.fingerprint = 1;
+    probe->body.stop_when_decided = 1;
+    return probe;
+}
+
+// Every discovered query parameter gets every payload; libcurl runs them concurrently under the batch's per-host cap
+int injection_scan_schedule(InjectionScan* scan, ProbeBatch* pb, const char* url) {
+    memset(scan, 0, sizeof(*scan));
+    const InjectionCorpus* c = injection_corpus_get();
+    if (!c || !pb || !url) return -1;
+
+    size_t url_len = strcspn(url, "#");
+    const char* q = memchr(url, '?', url_len);
+    const char* query = q ? q + 1 : NULL;
+    QueryParam params[INJECTION_MAX_PARAMS];
+    size_t param_count = 0;
+    if (query) param_count = parse_query(query, url_len - (size_t)(query - url), params, INJECTION_MAX_PARAMS, &scan->params_truncated);
+    scan->param_count = param_count ? param_count : 1;
+
+    size_t pairs = scan->param_count * c->payload_count;
+    if (pairs > INJECTION_MAX_PROBES) {
+        pairs = INJECTION_MAX_PROBES;
+        scan->truncated = 1;
+    }
+    scan->probes = calloc(pairs, sizeof(*scan->probes));
+    if (!scan->probes) return -1;
+
+    char* base_url = strndup(url, url_len);
+    if (base_url) {
+        scan->baseline = add_probe(pb, base_url, c, NULL);
+        free(base_url);
+    }
+
+    for (size_t p = 0; p < c->payload_count && scan->count < pairs; p++) {
+        char* escaped = curl_easy_escape(NULL, c->payloads[p].payload, 0);
+        if (!escaped) continue;
+        for (size_t t = 0; t < scan->param_count && scan->count < pairs; t++) {
+            // With no named parameter in the URL a synthetic one is appended after whatever query there was
+            const QueryParam* target = param_count ? &params[t] : NULL;
+            char* probe_url = build_probe_url(url, url_len, query, target, INJECTION_DEFAULT_PARAM, escaped);
+            if (!probe_url) continue;
+            InjectionProbe* ip = &scan->probes[scan->count++];
+            ip->probe = add_probe(pb, probe_url, c, &c->payloads[p]);
+            ip->payload = p;
+            if (target) snprintf(ip->param, sizeof(ip->param), "%.*s", (int)target->name_len, target->name);
+            else snprintf(ip->param, sizeof(ip->param), "%s", INJECTION_DEFAULT_PARAM);
+            free(probe_url);
+        }
+        curl_free(escaped);
+    }
+    return 0;
+}
+
+// Status, Content-Type and the fingerprinted body prefix; headers that change per request are ignored
+static int same_response(const HttpProbe* a, const HttpProbe* b) {
+    if (a->http_code != b->http_code) return 0;
+    if (a->body.fingerprint_len != b->body.fingerprint_len || a->body.fingerprint_hash != b->body.fingerprint_hash) return 0;
+    int ta = find_header_id(&a->headers, HDR_CONTENT_TYPE);
+    int tb = find_header_id(&b->headers, HDR_CONTENT_TYPE);
+    if (ta < 0 || tb < 0) return ta == tb;
+    return strcasecmp(header_value_at(&a->headers, ta), header_value_at(&b->headers, tb)) == 0;
+}
+
+static int probe_ok(const HttpProbe* probe) {
+    return probe && probe->done && probe->result == CURLE_OK;
+}
+
+// Signatures are matched while each body streams in, before its fingerprint is complete, so there is no
+// matching left to share between identical responses here; skipping repeats could only hide hits on other
+// parameters. Only responses identical to the baseline are set aside.
+void injection_scan_evaluate(const InjectionScan* scan, ReportList* rl) {
+    const InjectionCorpus* c = injection_corpus_get();
+    if (!c || !scan->probes) {
+        report_add(rl, SEV_WARNING, "Failed to init curl for injection test.");
+        return;
+    }
+
+    const HttpProbe* baseline = probe_ok(scan->baseline) ? scan->baseline : NULL;
+    size_t failed = 0, unchanged = 0;
+
+    for (size_t i = 0; i < scan->count; i++) {
+        const InjectionProbe* ip = &scan->probes[i];
+        const InjectionPayload* payload = &c->payloads[ip->payload];
+        if (!probe_ok(ip->probe)) {
+            failed++;
+            continue;
+        }
+        // A page the payload did not change up to the match cannot reflect it; the signature belongs to the
+        // page itself. Past the fingerprinted prefix there is nothing to compare, so such a match is reported.
+        const BodyInspector* body = &ip->probe->body;
+        if (baseline && same_response(ip->probe, baseline)) {
+            unchanged++;
+            if (!body->matched || body->first_match_end <= BODY_FINGERPRINT_PREFIX) continue;
+        }
+        if (body->matched) {
+            report_add(rl, SEV_CRITICAL, "Potential %s vulnerability detected in parameter '%s' with payload: %s.",
+                       payload->kind, ip->param, payload->payload);
+        }
+    }
+
+    if (failed) report_add(rl, SEV_WARNING, "Injection test failed for %zu of %zu probes.", failed, scan->count);
+    report_add(rl, SEV_INFO, "Injection scan sent %zu probes over %zu parameter(s); %zu matched the baseline page.",
+               scan->count, scan->param_count, unchanged);
+    if (scan->params_truncated) report_add(rl, SEV_INFO, "Injection scan tested the first %d parameter names only.", INJECTION_MAX_PARAMS);
+    if (scan->truncated) report_add(rl, SEV_INFO, "Injection scan capped at %d probes.", INJECTION_MAX_PROBES);
+}
+
+void injection_scan_free(InjectionScan* scan) {
+    if (!scan) return;
+    free(scan->probes);
+    memset(scan, 0, sizeof(*scan));
+}
@@ -0,0 +1,146 @@
+#include "../../include/scanner/pattern_matcher.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NO_STATE UINT32_MAX
+
+int pattern_matcher_build(PatternMatcher* pm, const char* const* patterns, size_t count) {
+    if (!pm || (!patterns && count)) return -1;
+    memset(pm, 0, sizeof(*pm));
+    pm->pattern_count = count;
+
+    // Only bytes that occur in some pattern get their own column; case folding happens here, once
+    size_t total_len = 0;
+    pm->class_count = 1;
+    for (size_t p = 0; p < count; p++) {
+        for (const unsigned char* c = (const unsigned char*)patterns[p]; *c; c++, total_len++) {
+            unsigned char lower = (unsigned char)tolower(*c);
+            if (pm->byte_class[lower]) continue;
+            pm->byte_class[lower] = (uint8_t)pm->class_count;
+            pm->byte_class[toupper(lower)] = (uint8_t)pm->class_count;
+            pm->class_count++;
+        }
+    }
+
+    size_t max_states = total_len + 1;
+    const size_t cc = pm->class_count;
+    pm->delta = malloc(max_states * cc * sizeof(*pm->delta));
+    uint32_t* fail = calloc(max_states, sizeof(*fail));
+    uint32_t* own_first = malloc(max_states * sizeof(*own_first));
+    uint32_t* own_next = malloc((count ? count : 1) * sizeof(*own_next));
+    uint32_t* queue = malloc(max_states * sizeof(*queue));
+    pm->out_offset = calloc(max_states + 1, sizeof(*pm->out_offset));
+    if (!pm->delta || !fail || !own_first || !own_next || !queue || !pm->out_offset) goto fail;
+
+    for (size_t i = 0; i < max_states * cc; i++) pm->delta[i] = NO_STATE;
+    for (size_t i = 0; i < max_states; i++) own_first[i] = NO_STATE;
+    pm->state_count = 1;
+
+    // Trie
+    for (size_t p = 0; p < count; p++) {
+        if (!patterns[p][0]) { own_next[p] = NO_STATE; continue; }
+        uint32_t s = PATTERN_MATCHER_START;
+        for (const unsigned char* c = (const unsigned char*)patterns[p]; *c; c++) {
+            uint32_t* slot = &pm->delta[s * cc + pm->byte_class[*c]];
+            if (*slot == NO_STATE) *slot = (uint32_t)pm->state_count++;
+            s = *slot;
+        }
+        own_next[p] = own_first[s];
+        own_first[s] = (uint32_t)p;
+    }
+
+    // Breadth-first failure links, folding missing edges into full DFA transitions
+    size_t head = 0, tail = 0;
+    for (size_t c = 0; c < cc; c++) {
+        uint32_t* slot = &pm->delta[c];
+        if (*slot == NO_STATE) { *slot = PATTERN_MATCHER_START; continue; }
+        fail[*slot] = PATTERN_MATCHER_START;
+        queue[tail++] = *slot;
+    }
+    while (head < tail) {
+        uint32_t r = queue[head++];
+        for (size_t c = 0; c < cc; c++) {
+            uint32_t* slot = &pm->delta[r * cc + c];
+            uint32_t via_fail = pm->delta[fail[r] * cc + c];
+            if (*slot == NO_STATE) { *slot = via_fail; continue; }
+            fail[*slot] = via_fail;
+            queue[tail++] = *slot;
+        }
+    }
+
+    // Outputs: a state reports its own patterns plus everything its failure state reports
+    size_t total_out = 0;
+    for (size_t i = 0; i < tail + 1; i++) {
+        uint32_t s = i == 0 ? PATTERN_MATCHER_START : queue[i - 1];
+        uint32_t n = 0;
+        for (uint32_t p = own_first[s]; p != NO_STATE; p = own_next[p]) n++;
+        if (s != PATTERN_MATCHER_START) n += pm->out_offset[fail[s] + 1];
+        pm->out_offset[s + 1] = n; // temporarily the per-state count
+        total_out += n;
+    }
+    pm->out_ids = malloc((total_out ? total_out : 1) * sizeof(*pm->out_ids));
+    uint32_t* counts = malloc(pm->state_count * sizeof(*counts));
+    if (!pm->out_ids || !counts) { free(counts); goto fail; }
+    for (size_t s = 0; s < pm->state_count; s++) counts[s] = pm->out_offset[s + 1];
+    pm->out_offset[0] = 0;
+    for (size_t s = 0; s < pm->state_count; s++) pm->out_offset[s + 1] = pm->out_offset[s] + counts[s];
+    free(counts);
+    for (size_t i = 0; i < tail; i++) {
+        uint32_t s = queue[i];
+        uint32_t* dst = &pm->out_ids[pm->out_offset[s]];
+        for (uint32_t p = own_first[s]; p != NO_STATE; p = own_next[p]) *dst++ = p;
+        uint32_t f = fail[s];
+        memcpy(dst, &pm->out_ids[pm->out_offset[f]], (pm->out_offset[f + 1] - pm->out_offset[f]) * sizeof(*dst));
+    }
+
+    free(fail);
+    free(own_first);
+    free(own_next);
+    free(queue);
+    return 0;
+
+fail:
+    fprintf(stderr, "Failed to build pattern matcher\n");
+    free(fail);
+    free(own_first);
+    free(own_next);
+    free(queue);
+    pattern_matcher_free(pm);
+    return -1;
+}
+
+void pattern_matcher_free(PatternMatcher* pm) {
+    if (!pm) return;
+    free(pm->delta);
+    free(pm->out_offset);
+    free(pm->out_ids);
+    memset(pm, 0, sizeof(*pm));
+}
+
+// Feeds one buffer through the automaton starting from 'state'; pass the returned state to the next call to scan a stream
+uint32_t pattern_matcher_scan(const PatternMatcher* pm, uint32_t state, const char* data, size_t len,
+                              PatternMatchFn on_match, void* ctx) {
+    if (!pm || !pm->delta) return state;
+    const size_t cc = pm->class_count;
+    for (size_t i = 0; i < len; i++) {
+        state = pm->delta[state * cc + pm->byte_class[(unsigned char)data[i]]];
+        uint32_t begin = pm->out_offset[state], end = pm->out_offset[state + 1];
+        for (uint32_t o = begin; o < end; o++) {
+            if (on_match && on_match(pm->out_ids[o], i + 1, ctx)) return state;
+        }
+    }
+    return state;
+}
+
+static int mark_hit(size_t pattern_id, size_t end_offset, void* ctx) {
+    (void)end_offset;
+    ((unsigned char*)ctx)[pattern_id] = 1;
+    return 0;
+}
+
+// One-shot scan of a whole buffer; hits must hold pattern_count entries and is not cleared
+void pattern_matcher_mark(const PatternMatcher* pm, const char* data, size_t len, unsigned char* hits) {
+    pattern_matcher_scan(pm, PATTERN_MATCHER_START, data, len, mark_hit, hits);
+}
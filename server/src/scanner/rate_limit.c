@@ -0,0 +1,183 @@
+#include "../../include/scanner/rate_limit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Headers that advertise a limit, in the order they are reported
+static const HeaderId rate_limit_headers[] = {
+    HDR_RETRY_AFTER, HDR_RATELIMIT, HDR_RATELIMIT_POLICY, HDR_RATELIMIT_LIMIT, HDR_RATELIMIT_REMAINING,
+    HDR_RATELIMIT_RESET, HDR_X_RATE_LIMIT, HDR_X_RATELIMIT_LIMIT, HDR_X_RATELIMIT_REMAINING, HDR_X_RATELIMIT_RESET
+};
+
+#define RATE_LIMIT_HEADER_COUNT (sizeof(rate_limit_headers) / sizeof(rate_limit_headers[0]))
+
+int rate_limit_burst_start(RateLimitBurst* burst, ProbeBatch* pb, const char* url, int size, int rate) {
+    memset(burst, 0, sizeof(*burst));
+    if (!pb || !url) return -1;
+    burst->size = size <= 0 ? RATE_LIMIT_BURST_DEFAULT : size > RATE_LIMIT_BURST_MAX ? RATE_LIMIT_BURST_MAX : size;
+    burst->rate = rate <= 0 ? 0 : rate > RATE_LIMIT_RATE_MAX ? RATE_LIMIT_RATE_MAX : rate;
+    burst->url = strdup(url);
+    burst->probes = calloc((size_t)burst->size, sizeof(*burst->probes));
+    if (!burst->url || !burst->probes) {
+        rate_limit_burst_free(burst);
+        return -1;
+    }
+    burst->start_ns = probe_monotonic_ns();
+    rate_limit_burst_pump(burst, pb);
+    return 0;
+}
+
+// Hands every request that is due to the batch; returns milliseconds until the next one, or -1 once all are out
+long rate_limit_burst_pump(RateLimitBurst* burst, ProbeBatch* pb) {
+    if (!burst->probes || burst->sent >= burst->size) return -1;
+
+    int due = burst->size;
+    uint64_t elapsed = probe_monotonic_ns() - burst->start_ns;
+    if (burst->rate > 0) {
+        uint64_t released = elapsed * (uint64_t)burst->rate / 1000000000ull + 1;
+        due = released < (uint64_t)burst->size ? (int)released : burst->size;
+    }
+    for (; burst->sent < due; burst->sent++) {
+        HttpProbe* probe = probe_batch_add(pb, burst->url, PROBE_TIMEOUT_S);
+        // Only status and headers are evaluated
+        if (probe) probe->body.headers_only = 1;
+        burst->probes[burst->sent] = probe;
+    }
+    if (burst->sent >= burst->size) return -1;
+
+    uint64_t next_ns = (uint64_t)burst->sent * 1000000000ull / (uint64_t)burst->rate;
+    return next_ns > elapsed ? (long)((next_ns - elapsed + 999999) / 1000000) : 0;
+}
+
+// Drives the whole batch, not just the burst, until every transfer has finished and nothing is left to send
+void rate_limit_burst_wait(RateLimitBurst* burst, ProbeBatch* pb) {
+    if (!pb || !pb->multi) return;
+    for (;;) {
+        long next_ms = rate_limit_burst_pump(burst, pb);
+        int running = probe_batch_step(pb);
+        if (running == 0 && next_ms < 0) break;
+        int timeout = PROBE_POLL_TIMEOUT_MS;
+        if (next_ms >= 0 && next_ms < timeout) timeout = (int)next_ms;
+        if (curl_multi_poll(pb->multi, NULL, 0, timeout, NULL) != CURLM_OK) break;
+    }
+}
+
+static int compare_latency(const void* a, const void* b) {
+    curl_off_t x = *(const curl_off_t*)a, y = *(const curl_off_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile over sorted samples
+static curl_off_t percentile(const curl_off_t* sorted, int n, int p) {
+    int rank = (p * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Server think time: request fully sent to first response byte, so connection queueing is left out
+static curl_off_t server_latency(const HttpProbe* probe) {
+    curl_off_t latency = probe->ttfb_us - probe->pretransfer_us;
+    return latency > 0 ? latency : 0;
+}
+
+static int probe_ok(const HttpProbe* probe) {
+    return probe && probe->done && probe->result == CURLE_OK;
+}
+
+void rate_limit_burst_evaluate(const RateLimitBurst* burst, ReportList* rl) {
+    if (!burst->probes) {
+        report_add(rl, SEV_WARNING, "Failed to init curl for rate limiting test.");
+        return;
+    }
+
+    int failed = 0, limited = 0, first_limited = -1, streams = 0;
+    long connections = 0;
+    CURLcode first_error = CURLE_OK;
+    int header_seen[RATE_LIMIT_HEADER_COUNT] = {0};
+    int detected = 0;
+    curl_off_t* samples = malloc((size_t)burst->size * sizeof(*samples));
+    curl_off_t* ordered = malloc((size_t)burst->size * sizeof(*ordered)); // same samples in send order
+    int n = 0;
+
+    for (int i = 0; i < burst->sent; i++) {
+        const HttpProbe* probe = burst->probes[i];
+        if (!probe_ok(probe)) {
+            if (!failed) first_error = probe ? (probe->done ? probe->result : CURLE_OPERATION_TIMEDOUT) : CURLE_FAILED_INIT;
+            failed++;
+            continue;
+        }
+        if (probe->http_version == CURL_HTTP_VERSION_2_0) streams++;
+        connections += probe->new_connections;
+
+        int throttled = probe->http_code == 429 || (probe->http_code == 503 && find_header_id(&probe->headers, HDR_RETRY_AFTER) >= 0);
+        if (throttled) {
+            limited++;
+            if (first_limited < 0) first_limited = i;
+        } else if (samples && ordered) {
+            samples[n] = ordered[n] = server_latency(probe);
+            n++;
+        }
+
+        for (size_t h = 0; h < RATE_LIMIT_HEADER_COUNT; h++) {
+            int idx = header_seen[h] ? -1 : find_header_id(&probe->headers, rate_limit_headers[h]);
+            if (idx < 0) continue;
+            header_seen[h] = 1;
+            detected = 1;
+            report_add(rl, SEV_INFO, "Rate limiting header '%s: %s' detected.",
+                       header_name_at(&probe->headers, idx), header_value_at(&probe->headers, idx));
+        }
+    }
+
+    if (failed) {
+        report_add(rl, SEV_WARNING, "Rate limiting test failed for %d of %d requests: %s.", failed, burst->sent, curl_easy_strerror(first_error));
+    }
+    if (limited) {
+        long code = burst->probes[first_limited]->http_code;
+        report_add(rl, SEV_INFO, "Rate limiting detected: HTTP %ld%s after %d of %d requests (%d throttled).",
+                   code, code == 429 ? " Too Many Requests" : " Service Unavailable with Retry-After",
+                   first_limited + 1, burst->sent, limited);
+        detected = 1;
+    }
+
+    if (n > 0) {
+        qsort(samples, (size_t)n, sizeof(*samples), compare_latency);
+        curl_off_t p50 = percentile(samples, n, 50), p99 = percentile(samples, n, 99);
+        char mode[32];
+        if (burst->rate) snprintf(mode, sizeof(mode), "%d req/s", burst->rate);
+        else snprintf(mode, sizeof(mode), "concurrent");
+        report_add(rl, SEV_INFO, "Rate limiting burst of %d requests (%s): p50 %.1f ms, p99 %.1f ms.",
+                   burst->sent, mode, p50 / 1000.0, p99 / 1000.0);
+
+        if (n >= 4) {
+            // Throttling by delay slows the later part of a burst; plain overload spikes anywhere in it
+            int half = n / 2;
+            qsort(ordered, (size_t)half, sizeof(*ordered), compare_latency);
+            qsort(ordered + half, (size_t)(n - half), sizeof(*ordered), compare_latency);
+            curl_off_t early = percentile(ordered, half, 50), late = percentile(ordered + half, n - half, 50);
+            if (late >= early * 2 && late - early >= RATE_LIMIT_INFLATION_MIN_US) {
+                report_add(rl, SEV_INFO, "Latency inflation under burst: later requests slowed from %.1f ms to %.1f ms, consistent with delay-based throttling.",
+                           early / 1000.0, late / 1000.0);
+                detected = 1;
+            } else if (p99 >= p50 * RATE_LIMIT_INFLATION_RATIO && p99 - p50 >= RATE_LIMIT_INFLATION_MIN_US) {
+                report_add(rl, SEV_WARNING, "Latency inflation under burst (p99 %.1fx p50) without a trend; looks like server slowdown rather than throttling.",
+                           p50 ? (double)p99 / (double)p50 : 0.0);
+            }
+        }
+    }
+    free(samples);
+    free(ordered);
+
+    if (!detected) {
+        report_add(rl, SEV_WARNING, "No rate limiting detected after %d requests.", burst->sent);
+    }
+    // Over HTTP/2 the burst arrives as concurrent streams, so a server limiting per connection shows up here
+    if (streams > 0) {
+        report_add(rl, SEV_INFO, "Rate limiting burst sent as %d concurrent HTTP/2 streams; %ld new connection(s) opened.", streams, connections);
+    }
+}
+
+void rate_limit_burst_free(RateLimitBurst* burst) {
+    if (!burst) return;
+    free(burst->url);
+    free(burst->probes);
+    memset(burst, 0, sizeof(*burst));
+}
@@ -0,0 +1,128 @@
+#include "../../include/scanner/simd_search.h"
+#include <pthread.h>
+#include <stdint.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SIMD_SEARCH_X86 1
+#endif
+
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+static inline int caseeq(const char* a, const char* b, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (fold((unsigned char)a[i]) != fold((unsigned char)b[i])) return 0;
+    }
+    return 1;
+}
+
+static inline unsigned char other_case(unsigned char c) {
+    if (c >= 'a' && c <= 'z') return (unsigned char)(c - 0x20);
+    if (c >= 'A' && c <= 'Z') return (unsigned char)(c | 0x20);
+    return c;
+}
+
+const char* simd_casefind_scalar(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return haystack;
+    if (needle_len > haystack_len) return NULL;
+    const unsigned char first = fold((unsigned char)needle[0]);
+    for (size_t i = 0; i <= haystack_len - needle_len; i++) {
+        if (fold((unsigned char)haystack[i]) != first) continue;
+        if (caseeq(haystack + i + 1, needle + 1, needle_len - 1)) return haystack + i;
+    }
+    return NULL;
+}
+
+#ifdef SIMD_SEARCH_X86
+// Candidate positions are those where both the first and the last needle byte match (in either case);
+// only those are verified byte by byte
+static const char* casefind_sse2(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return haystack;
+    if (needle_len > haystack_len) return NULL;
+
+    const unsigned char f = (unsigned char)needle[0], l = (unsigned char)needle[needle_len - 1];
+    const __m128i first_a = _mm_set1_epi8((char)f), first_b = _mm_set1_epi8((char)other_case(f));
+    const __m128i last_a = _mm_set1_epi8((char)l), last_b = _mm_set1_epi8((char)other_case(l));
+
+    size_t i = 0;
+    for (; i + needle_len - 1 + 16 <= haystack_len; i += 16) {
+        const __m128i block_first = _mm_loadu_si128((const __m128i*)(haystack + i));
+        const __m128i block_last = _mm_loadu_si128((const __m128i*)(haystack + i + needle_len - 1));
+        const __m128i eq_first = _mm_or_si128(_mm_cmpeq_epi8(block_first, first_a), _mm_cmpeq_epi8(block_first, first_b));
+        const __m128i eq_last = _mm_or_si128(_mm_cmpeq_epi8(block_last, last_a), _mm_cmpeq_epi8(block_last, last_b));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (needle_len <= 2 || caseeq(haystack + i + bit + 1, needle + 1, needle_len - 2)) return haystack + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return simd_casefind_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+
+__attribute__((target("avx2")))
+static const char* casefind_avx2(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return haystack;
+    if (needle_len > haystack_len) return NULL;
+
+    const unsigned char f = (unsigned char)needle[0], l = (unsigned char)needle[needle_len - 1];
+    const __m256i first_a = _mm256_set1_epi8((char)f), first_b = _mm256_set1_epi8((char)other_case(f));
+    const __m256i last_a = _mm256_set1_epi8((char)l), last_b = _mm256_set1_epi8((char)other_case(l));
+
+    size_t i = 0;
+    for (; i + needle_len - 1 + 32 <= haystack_len; i += 32) {
+        const __m256i block_first = _mm256_loadu_si256((const __m256i*)(haystack + i));
+        const __m256i block_last = _mm256_loadu_si256((const __m256i*)(haystack + i + needle_len - 1));
+        const __m256i eq_first = _mm256_or_si256(_mm256_cmpeq_epi8(block_first, first_a), _mm256_cmpeq_epi8(block_first, first_b));
+        const __m256i eq_last = _mm256_or_si256(_mm256_cmpeq_epi8(block_last, last_a), _mm256_cmpeq_epi8(block_last, last_b));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last));
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (needle_len <= 2 || caseeq(haystack + i + bit + 1, needle + 1, needle_len - 2)) return haystack + i + bit;
+            mask &= mask - 1;
+        }
+    }
+    return simd_casefind_scalar(haystack + i, haystack_len - i, needle, needle_len);
+}
+
+const CasefindFn simd_casefind_sse2_fn = casefind_sse2;
+const CasefindFn simd_casefind_avx2_fn = casefind_avx2;
+
+int simd_casefind_avx2_supported(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#else
+const CasefindFn simd_casefind_sse2_fn = NULL;
+const CasefindFn simd_casefind_avx2_fn = NULL;
+
+int simd_casefind_avx2_supported(void) {
+    return 0;
+}
+#endif
+
+static CasefindFn casefind_impl = simd_casefind_scalar;
+static const char* casefind_impl_name = "scalar";
+static pthread_once_t casefind_once = PTHREAD_ONCE_INIT;
+
+static void select_impl(void) {
+    if (simd_casefind_avx2_fn && simd_casefind_avx2_supported()) {
+        casefind_impl = simd_casefind_avx2_fn;
+        casefind_impl_name = "avx2";
+    } else if (simd_casefind_sse2_fn) {
+        casefind_impl = simd_casefind_sse2_fn; // baseline on x86-64
+        casefind_impl_name = "sse2";
+    }
+}
+
+const char* simd_casefind(const char* haystack, size_t haystack_len, const char* needle, size_t needle_len) {
+    pthread_once(&casefind_once, select_impl);
+    return casefind_impl(haystack, haystack_len, needle, needle_len);
+}
+
+const char* simd_casefind_impl_name(void) {
+    pthread_once(&casefind_once, select_impl);
+    return casefind_impl_name;
+}
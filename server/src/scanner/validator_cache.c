@@ -0,0 +1,120 @@
+#include "../../include/scanner/validator_cache.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t hash;
+    char* url;
+    ValidatorEntry entry;
+} ValidatorSlot;
+
+static ValidatorSlot validator_cache[VALIDATOR_CACHE_SLOTS];
+static pthread_mutex_t validator_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t hash_url(const char* url) {
+    uint64_t h = 1469598103934665603ull;
+    for (const unsigned char* p = (const unsigned char*)url; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Appends the headers of src whose names are not in skip (which may be NULL)
+static void copy_headers(HeaderCollection* dst, const HeaderCollection* src, const HeaderCollection* skip) {
+    for (int i = 0; i < src->count; i++) {
+        const HttpHeader* hdr = &src->headers[i];
+        if (skip && find_header(skip, header_name_at(src, i)) >= 0) continue;
+        add_header_n(dst, header_name_at(src, i), hdr->name_len, header_value_at(src, i), hdr->value_len);
+    }
+}
+
+static void copy_validator(char* dst, size_t dst_size, const HeaderCollection* hc, const char* name) {
+    int idx = find_header(hc, name);
+    snprintf(dst, dst_size, "%s", idx >= 0 ? header_value_at(hc, idx) : "");
+}
+
+// Returns 1 and a private copy of the entry (release with validator_entry_free) when url was fetched before
+int validator_cache_lookup(const char* url, ValidatorEntry* out) {
+    if (!url || !out) return 0;
+    uint64_t hash = hash_url(url);
+    ValidatorSlot* slot = &validator_cache[hash % VALIDATOR_CACHE_SLOTS];
+
+    pthread_mutex_lock(&validator_cache_lock);
+    if (!slot->url || slot->hash != hash || strcmp(slot->url, url) != 0) {
+        pthread_mutex_unlock(&validator_cache_lock);
+        return 0;
+    }
+    *out = slot->entry;
+    memset(&out->headers, 0, sizeof(out->headers));
+    copy_headers(&out->headers, &slot->entry.headers, NULL);
+    pthread_mutex_unlock(&validator_cache_lock);
+    return 1;
+}
+
+static void store_entry(const char* url, const HeaderCollection* headers, const BodyInspector* body, const unsigned char* digest, time_t stored_at) {
+    ValidatorEntry entry = { .body = *body, .stored_at = stored_at };
+    copy_validator(entry.etag, sizeof(entry.etag), headers, "etag");
+    copy_validator(entry.last_modified, sizeof(entry.last_modified), headers, "last-modified");
+    if (digest) {
+        memcpy(entry.digest, digest, PROBE_DIGEST_SIZE);
+        entry.has_digest = 1;
+    }
+    copy_headers(&entry.headers, headers, NULL);
+
+    char* key = strdup(url);
+    if (!key) {
+        fprintf(stderr, "Memory allocation failed\n");
+        header_collection_free(&entry.headers);
+        return;
+    }
+
+    uint64_t hash = hash_url(url);
+    ValidatorSlot* slot = &validator_cache[hash % VALIDATOR_CACHE_SLOTS];
+    pthread_mutex_lock(&validator_cache_lock);
+    char* old_url = slot->url;
+    ValidatorEntry old_entry = slot->entry;
+    slot->hash = hash;
+    slot->url = key;
+    slot->entry = entry;
+    pthread_mutex_unlock(&validator_cache_lock);
+
+    free(old_url);
+    if (old_url) header_collection_free(&old_entry.headers);
+}
+
+void validator_cache_store(const char* url, const HeaderCollection* headers, const BodyInspector* body, const unsigned char* digest) {
+    if (!url || !headers || !body) return;
+    store_entry(url, headers, body, digest, time(NULL));
+}
+
+// The merged headers may carry new validators; the body findings and their age stay those of the last full fetch
+void validator_cache_refresh(const char* url, const ValidatorEntry* entry, const HeaderCollection* merged) {
+    if (!url || !entry || !merged) return;
+    store_entry(url, merged, &entry->body, entry->has_digest ? entry->digest : NULL, entry->stored_at);
+}
+
+// A 304 carries only the headers that changed; the rest are taken from the stored response (RFC 9111, 4.3.4)
+void validator_cache_merge_304(const ValidatorEntry* entry, const HeaderCollection* not_modified, HeaderCollection* out) {
+    copy_headers(out, not_modified, NULL);
+    copy_headers(out, &entry->headers, not_modified);
+}
+
+void validator_entry_free(ValidatorEntry* entry) {
+    if (!entry) return;
+    header_collection_free(&entry->headers);
+}
+
+void validator_cache_clear(void) {
+    pthread_mutex_lock(&validator_cache_lock);
+    for (size_t i = 0; i < VALIDATOR_CACHE_SLOTS; i++) {
+        if (!validator_cache[i].url) continue;
+        free(validator_cache[i].url);
+        header_collection_free(&validator_cache[i].entry.headers);
+        memset(&validator_cache[i], 0, sizeof(validator_cache[i]));
+    }
+    pthread_mutex_unlock(&validator_cache_lock);
+}